@@ -0,0 +1,159 @@
+/*
+ * Benchmarks for the Apt data provider
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "ept/test.h"
+#include "apt.h"
+#include <thread>
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::apt;
+
+namespace {
+
+struct AptBenchEnvironment {
+    AptBenchEnvironment() {
+        pkgInitConfig (*_config);
+        _config->Set("Initialized", 1);
+        _config->Set("Dir", ".");
+        _config->Set("Dir::Cache", "cache");
+        _config->Set("Dir::State", "state");
+        _config->Set("Dir::Etc", "etc");
+        _config->Set("Dir::Etc::sourcelist", "sources.list");
+        _config->Set("Dir::State::status", "./dpkg-status");
+        pkgInitSystem (*_config, _system);
+    }
+};
+
+// Query the same Apt object from the given number of threads
+void concurrent_queries(Bench& b, unsigned thread_count)
+{
+    AptBenchEnvironment env;
+    Apt apt;
+    vector<string> names;
+    for (Apt::iterator i = apt.begin(); i != apt.end(); ++i)
+        names.push_back(*i);
+
+    size_t bytes = 0;
+    b.run([&] {
+        // Each thread adds up its own total, read after the join
+        vector<size_t> totals(thread_count, 0);
+        vector<std::thread> threads;
+        for (unsigned t = 0; t < thread_count; ++t)
+            threads.emplace_back([&, t] {
+                size_t total = 0;
+                for (const auto& name : names)
+                {
+                    total += apt.candidateVersion(name).version().size();
+                    total += apt.rawRecord(name).size();
+                }
+                totals[t] = total;
+            });
+        for (auto& t : threads)
+            t.join();
+        bytes = 0;
+        for (const auto& total : totals)
+            bytes += total;
+    });
+    b.bytes(bytes);
+    b.items(names.size() * thread_count);
+}
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("open", [](Bench& b) {
+            AptBenchEnvironment env;
+            b.run([] { Apt apt; });
+        });
+
+        add_method("record_iterator", [](Bench& b) {
+            AptBenchEnvironment env;
+            Apt apt;
+            size_t count = 0;
+            size_t bytes = 0;
+            b.run([&] {
+                count = bytes = 0;
+                for (Apt::record_iterator i = apt.recordBegin(); i != apt.recordEnd(); ++i)
+                {
+                    ++count;
+                    bytes += i->size();
+                }
+            });
+            b.bytes(bytes);
+            b.items(count);
+        });
+
+        add_method("record_range", [](Bench& b) {
+            AptBenchEnvironment env;
+            Apt apt;
+            Apt::RecordRange records = apt.records();
+            size_t bytes = 0;
+            b.run([&] {
+                bytes = 0;
+                for (size_t i = 0; i < records.size(); ++i)
+                    bytes += records[i].size();
+            });
+            b.bytes(bytes);
+            b.items(records.size());
+        });
+
+        add_method("raw_record", [](Bench& b) {
+            AptBenchEnvironment env;
+            Apt apt;
+            vector<Version> versions;
+            for (Apt::iterator i = apt.begin(); i != apt.end(); ++i)
+                versions.push_back(apt.anyVersion(*i));
+            size_t bytes = 0;
+            b.run([&] {
+                bytes = 0;
+                for (const auto& v : versions)
+                    bytes += apt.rawRecord(v).size();
+            });
+            b.bytes(bytes);
+            b.items(versions.size());
+        });
+
+        add_method("raw_records", [](Bench& b) {
+            AptBenchEnvironment env;
+            Apt apt;
+            vector<Version> versions;
+            for (Apt::iterator i = apt.begin(); i != apt.end(); ++i)
+                versions.push_back(apt.anyVersion(*i));
+            size_t bytes = 0;
+            b.run([&] {
+                bytes = 0;
+                for (const auto& r : apt.rawRecords(versions))
+                    bytes += r.size();
+            });
+            b.bytes(bytes);
+            b.items(versions.size());
+        });
+
+        add_method("concurrent_1", [](Bench& b) { concurrent_queries(b, 1); });
+        add_method("concurrent_2", [](Bench& b) { concurrent_queries(b, 2); });
+        add_method("concurrent_4", [](Bench& b) { concurrent_queries(b, 4); });
+    }
+} benchmarks("apt_apt");
+
+}
@@ -1,7 +1,11 @@
 #include "ept/test.h"
 #include "apt.h"
+#include "packagetable.h"
+#include "ept/utils/sys.h"
+#include "ept/utils/string.h"
 #include <set>
 #include <algorithm>
+#include <thread>
 
 using namespace std;
 using namespace ept;
@@ -134,6 +138,112 @@ class Tests : public TestCase
             wassert(actual(apt.rawRecord(pkg)) == apt.rawRecord(apt.anyVersion(pkg)));
         });
 
+        add_method("raw_records", []() {
+            // Check the batch raw record accessor
+            AptTestEnvironment env;
+            Apt apt;
+            vector<Version> vers;
+            for (Apt::iterator i = apt.begin(); i != apt.end(); ++i)
+                vers.push_back(apt.anyVersion(*i));
+            vers.push_back(Version("sp", "0.31415"));
+            // Request in reverse order, with a duplicate
+            reverse(vers.begin(), vers.end());
+            vers.push_back(vers.back());
+
+            vector<string> records = apt.rawRecords(vers);
+            wassert(actual(records.size()) == vers.size());
+            for (size_t i = 0; i < vers.size(); ++i)
+                wassert(actual(records[i]) == apt.rawRecord(vers[i]));
+            wassert(actual(records[0]) == string());
+
+            size_t count = 0;
+            apt.rawRecords(vers, [&](size_t idx, const string& record) {
+                ++count;
+                wassert(actual(record) == records[idx]);
+            });
+            wassert(actual(count) == vers.size() - 1);
+
+            vector<string> names { "sp", "does-not-exist" };
+            records = apt.rawRecords(names);
+            wassert(actual(records[0]) == apt.rawRecord(string("sp")));
+            wassert(actual(records[1]) == string());
+        });
+
+        add_method("record_cache", []() {
+            // Check the raw record cache
+            AptTestEnvironment env;
+            Apt apt;
+            Apt::RecordCacheStats stats = apt.recordCacheStats();
+            wassert(actual(stats.budget) == 0u);
+
+            // With no budget nothing is cached
+            string record = apt.rawRecord(string("sp"));
+            wassert(actual(apt.recordCacheStats().entries) == 0u);
+
+            apt.setRecordCacheSize(record.size());
+            wassert(actual(apt.rawRecord(string("sp"))) == record);
+            wassert(actual(apt.rawRecord(string("sp"))) == record);
+            stats = apt.recordCacheStats();
+            wassert(actual(stats.hits) == 1u);
+            wassert(actual(stats.misses) == 1u);
+            wassert(actual(stats.entries) == 1u);
+            wassert(actual(stats.bytes) == record.size());
+
+            // A different record does not fit with the first one, which gets
+            // evicted
+            Apt::iterator i = apt.begin();
+            if (*i == "sp") ++i;
+            string other = apt.rawRecord(*i);
+            stats = apt.recordCacheStats();
+            wassert(actual(stats.misses) == 2u);
+            wassert(actual(stats.entries) <= 1u);
+            wassert(actual(stats.bytes) <= record.size());
+
+            apt.setRecordCacheSize(0);
+            stats = apt.recordCacheStats();
+            wassert(actual(stats.entries) == 0u);
+            wassert(actual(stats.bytes) == 0u);
+        });
+
+        add_method("concurrent_queries", []() {
+            // Check that one Apt object can be queried from many threads
+            AptTestEnvironment env;
+            Apt apt;
+            apt.setRecordCacheSize(1024 * 1024);
+
+            vector<string> expected;
+            for (Apt::record_iterator i = apt.recordBegin(); i != apt.recordEnd(); ++i)
+                expected.push_back(*i);
+
+            // Use a fresh Apt, so that lazy initialisation happens concurrently
+            Apt shared;
+            shared.setRecordCacheSize(1024 * 1024);
+            vector<vector<string>> results(4);
+            vector<unsigned> installed(4, 0);
+            vector<std::thread> threads;
+            for (unsigned t = 0; t < results.size(); ++t)
+                threads.emplace_back([&, t] {
+                    for (Apt::record_iterator i = shared.recordBegin(); i != shared.recordEnd(); ++i)
+                        results[t].push_back(*i);
+                    for (Apt::iterator i = shared.begin(); i != shared.end(); ++i)
+                    {
+                        shared.rawRecord(*i);
+                        if (shared.state(*i).installed())
+                            ++installed[t];
+                    }
+                });
+            for (auto& t : threads)
+                t.join();
+
+            for (unsigned t = 0; t < results.size(); ++t)
+            {
+                wassert(actual(results[t] == expected).istrue());
+                wassert(actual(installed[t]) == installed[0]);
+            }
+            Apt::RecordCacheStats stats = shared.recordCacheStats();
+            wassert(actual(stats.hits + stats.misses) > 0u);
+        });
+
         add_method("state", []() {
             // Check the package state accessor
             AptTestEnvironment env;
@@ -176,6 +286,30 @@ class Tests : public TestCase
             wassert_true(count > 200);
         });
 
+        add_method("record_range", []() {
+            // Check random access to records
+            AptTestEnvironment env;
+            Apt apt;
+            vector<string> records;
+            std::copy(apt.recordBegin(), apt.recordEnd(), back_inserter(records));
+
+            Apt::RecordRange range = apt.records();
+            wassert(actual(range.size()) == records.size());
+            wassert(actual(range[0]) == records[0]);
+            wassert(actual(range[range.size() - 1]) == records.back());
+            wassert(actual(range[10]) == records[10]);
+            wassert(actual(range[5]) == records[5]);
+
+            Apt::RecordRange sub = range.subrange(100, 200);
+            wassert(actual(sub.size()) == 100u);
+            wassert(actual(sub[0]) == records[100]);
+            wassert(actual(sub.subrange(10, 20)[0]) == records[110]);
+            wassert_true(range.subrange(5, 5).empty());
+
+            wassert(actual_function([&]() { range[range.size()]; }).throws("out of range"));
+            wassert(actual_function([&]() { sub.subrange(50, 101); }).throws("out of range"));
+        });
+
         add_method("stl_iteration", []() {
             // Check that the iterators can be used with the algorithms
             AptTestEnvironment env;
@@ -192,6 +326,71 @@ class Tests : public TestCase
             std::copy(apt.recordBegin(), apt.recordEnd(), back_inserter(out));
         });
 
+        add_method("package_table", []() {
+            // Check building a columnar table from all the records
+            AptTestEnvironment env;
+            Apt apt;
+            size_t count = 0;
+            for (Apt::record_iterator i = apt.recordBegin(); i != apt.recordEnd(); ++i)
+                ++count;
+
+            PackageTableBuilder builder;
+            builder.add(apt);
+            PackageTable table = builder.build();
+            wassert(actual(table.size()) == count);
+
+            uint32_t code;
+            wassert_true(table.find(PackageTable::PackageName, "sp", code));
+            wassert_true(table.find(PackageTable::Section, "text", code));
+        });
+
+        add_method("derived_index", []() {
+            // Check sharing the derived data across Apt instances
+            AptTestEnvironment env;
+            vector<string> records;
+            vector<Version> candidates;
+            {
+                Apt apt;
+                for (Apt::record_iterator i = apt.recordBegin(); i != apt.recordEnd(); ++i)
+                    records.push_back(*i);
+                for (Apt::iterator i = apt.begin(); i != apt.end(); ++i)
+                    candidates.push_back(apt.candidateVersion(*i));
+            }
+
+            string pathname = str::joinpath(str::dirname(_config->FindFile("Dir::Cache::pkgcache")), "ept-derived.bin");
+            sys::unlink_ifexists(pathname);
+            _config->Set("Ept::CacheDerivedData", true);
+            for (unsigned pass = 0; pass < 2; ++pass)
+            {
+                // The first pass builds the index, the second one maps it
+                Apt apt;
+                vector<string> r;
+                for (Apt::record_iterator i = apt.recordBegin(); i != apt.recordEnd(); ++i)
+                    r.push_back(*i);
+                wassert_true(r == records);
+                wassert_true(sys::exists(pathname));
+
+                size_t idx = 0;
+                for (Apt::iterator i = apt.begin(); i != apt.end(); ++i, ++idx)
+                    wassert_true(apt.candidateVersion(*i) == candidates[idx]);
+                wassert_true(apt.isValid("sp"));
+                wassert_false(apt.isValid("does-not-exist"));
+            }
+            _config->Set("Ept::CacheDerivedData", false);
+            sys::unlink_ifexists(pathname);
+        });
+
+        add_method("startup_timings", []() {
+            // Check that the phases of opening the cache are timed
+            AptTestEnvironment env;
+            Apt apt;
+            const timings::PhaseTimings& t = apt.startupTimings();
+            wassert(actual(t.phases.size()) == 4u);
+            wassert(actual(t.phases[0].name) == "aptInit");
+            wassert(actual(t.phases[2].name) == "pkgMakeStatusCache");
+            wassert(actual(t.total()) >= t.get("ReadPinFile"));
+        });
+
         add_method("check_updates", []() {
             // Check that checkUpdates will keep a working Apt object
             AptTestEnvironment env;
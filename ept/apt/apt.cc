@@ -22,6 +22,9 @@
 
 #include "apt.h"
 #include "ept/utils/sys.h"
+#include "ept/utils/string.h"
+#include "ept/utils/timings.h"
+#include "ept/utils/instrument.h"
 #include <apt-pkg/error.h>
 #include <apt-pkg/init.h>
 #include <apt-pkg/progress.h>
@@ -30,8 +33,18 @@
 #include <apt-pkg/policy.h>
 #include <apt-pkg/cachefile.h>
 #include <vector>
+#include <list>
+#include <memory>
+#include <unordered_map>
+#include <mutex>
+#include <atomic>
 #include <algorithm>
 #include <iostream>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 using namespace std;
 
@@ -91,6 +104,123 @@ static void aptInit ()
 		throw Exception("initialising apt system");
 }
 
+struct AptImplementation;
+
+/**
+ * Cache of raw package records, keyed by their version file, with least
+ * recently used eviction.
+ */
+struct RecordCache
+{
+	typedef list< pair<const pkgCache::VerFile*, string> > Entries;
+
+	// Most recently used entries first
+	Entries entries;
+	unordered_map<const pkgCache::VerFile*, Entries::iterator> index;
+	size_t budget;
+	size_t bytes;
+	size_t hits;
+	size_t misses;
+
+	RecordCache(size_t budget) : budget(budget), bytes(0), hits(0), misses(0) {}
+
+	/// Look up a record, returning 0 if it is not in the cache
+	const string* get(const pkgCache::VerFile* vf)
+	{
+		auto i = index.find(vf);
+		if (i == index.end())
+		{
+			++misses;
+			return 0;
+		}
+		++hits;
+		entries.splice(entries.begin(), entries, i->second);
+		return &i->second->second;
+	}
+
+	/// Add a record to the cache, evicting old ones to make room for it
+	void put(const pkgCache::VerFile* vf, const string& record)
+	{
+		if (record.size() > budget || index.find(vf) != index.end())
+			return;
+		shrink(budget - record.size());
+		entries.push_front(make_pair(vf, record));
+		index[vf] = entries.begin();
+		bytes += record.size();
+	}
+
+	/// Evict the least recently used entries until at most size bytes are used
+	void shrink(size_t size)
+	{
+		while (bytes > size)
+		{
+			bytes -= entries.back().second.size();
+			index.erase(entries.back().first);
+			entries.pop_back();
+		}
+	}
+
+	void resize(size_t size)
+	{
+		budget = size;
+		shrink(size);
+	}
+};
+
+namespace {
+struct DerivedIndexHeader;
+}
+
+/**
+ * Data derived from the apt cache that is expensive to compute, in a format
+ * that can be saved to disk and mapped back in memory by other processes.
+ *
+ * After a DerivedIndexHeader, the image contains three arrays of uint32_t:
+ * the VerFile indices of the records sorted by localityCompare, the Version
+ * index of the candidate of each package (or no_id), and an open addressing
+ * hash table mapping package names to their package index (or no_id for
+ * empty slots).
+ */
+struct DerivedIndex
+{
+	// Image storage, when the index has been built in memory
+	std::string image;
+	// Image storage, when the index has been loaded from a file
+	sys::MMap map;
+
+	const DerivedIndexHeader* header;
+	const uint32_t* records;
+	const uint32_t* candidates;
+	const uint32_t* hash;
+
+	DerivedIndex() : map(MAP_FAILED, 0), header(0), records(0), candidates(0), hash(0) {}
+
+	bool valid() const { return header != 0; }
+
+	/**
+	 * Point the tables inside an image, after checking that it belongs to the
+	 * current apt cache.
+	 *
+	 * @return false if the image is stale or malformed
+	 */
+	bool attach(AptImplementation& apt, const char* data, size_t size);
+
+	/**
+	 * Map an index saved with save(), returning false if it is missing,
+	 * stale or cannot be read
+	 */
+	bool load(AptImplementation& apt, const std::string& pathname);
+
+	/// Compute the index for the current apt cache
+	void build(AptImplementation& apt);
+
+	/// Atomically save the index, ignoring failures since it is only a cache
+	void save(const std::string& pathname) const;
+
+	/// Look up a package by name, returning its index or no_id
+	uint32_t findPackage(pkgCache& cache, const std::string& name) const;
+};
+
 struct AptImplementation
 {
 	pkgSourceList* m_list;
@@ -99,28 +229,58 @@ struct AptImplementation
 	pkgCache* m_cache;
 	pkgPolicy* m_policy;
 	pkgCacheFile* m_depcache;
+	std::once_flag m_depcache_once;
 	time_t m_open_timestamp;
+	// Data derived from the cache, possibly shared with other processes
+	DerivedIndex m_index;
+	std::once_flag m_index_once;
+	// Locality-sorted version files of the records, built on first use
+	vector<pkgCache::VerFile*> m_records;
+	std::once_flag m_records_once;
+	RecordCache m_record_cache;
+	std::mutex m_record_cache_mutex;
+	// Time spent in each phase of the construction
+	timings::PhaseTimings m_timings;
 	
-	AptImplementation() : m_list(0), m(0), m_cache(0), m_policy(0), m_depcache(0), m_open_timestamp(0)
+	// Use this record cache size to read it from the apt configuration
+	static const size_t default_record_cache_size = (size_t)-1;
+
+	AptImplementation(size_t record_cache_size = default_record_cache_size)
+		: m_list(0), m(0), m_cache(0), m_policy(0), m_depcache(0), m_open_timestamp(0),
+		  m_record_cache(0)
 	{
+		timings::Timer init(m_timings, "aptInit");
 		// Init the apt library if needed
 		aptInit();
+		init.stop();
+
+		if (record_cache_size == default_record_cache_size)
+			record_cache_size = _config->FindI("Ept::RecordCacheSize", 0);
+		m_record_cache.budget = record_cache_size;
 
 		m_open_timestamp = aptTimestamp();
 
+		timings::Timer sources(m_timings, "ReadMainList");
 		m_list = new pkgSourceList;
 		if (!m_list->ReadMainList())
 			throw Exception("reading list of sources");
+		sources.stop();
 
+		timings::Timer status(m_timings, "pkgMakeStatusCache");
 		bool res = pkgMakeStatusCache(*m_list, progress, &m, true);
 		progress.Done();
 		if (!res)
 			throw Exception("Reading the package lists or status file");
+		status.stop();
 
+		timings::Timer pins(m_timings, "ReadPinFile");
 		m_cache = new pkgCache(m);
 		m_policy = new pkgPolicy(m_cache);
 		if (!ReadPinFile(*m_policy))
 			throw Exception("Reading the policy pin file");
+		pins.stop();
+
+		m_timings.report("ept: Apt startup");
 	}
 
 	~AptImplementation()
@@ -144,14 +304,46 @@ struct AptImplementation
 
 	pkgCacheFile& depcache()
 	{
-		if (!m_depcache)
-		{
-			m_depcache = new pkgCacheFile;
-			if (!m_depcache->Open(progress, false))
+		// If opening fails, the next call will try again
+		std::call_once(m_depcache_once, [this] {
+			pkgCacheFile* depcache = new pkgCacheFile;
+			if (!depcache->Open(progress, false))
+			{
+				delete depcache;
 				throw Exception("Opening the cache file");
-		}
+			}
+			m_depcache = depcache;
+		});
 		return *m_depcache;
 	}
+
+	/**
+	 * Return the index of data derived from the cache, which is not valid()
+	 * unless enabled in the configuration.
+	 */
+	const DerivedIndex& index();
+
+	/// Look up a package by name, using the derived index if available
+	pkgCache::PkgIterator findPkg(const std::string& name);
+
+	/// Return the candidate version of a package, using the derived index if
+	/// available
+	pkgCache::VerIterator candidate(pkgCache::PkgIterator& pi);
+
+	/// Compute the candidate version of a package with the apt policy
+	pkgCache::VerIterator policyCandidate(pkgCache::PkgIterator& pi)
+	{
+		instrument::count(instrument::GetCandidateVer);
+		return policy().GetCandidateVer(pi);
+	}
+
+	/**
+	 * Return the version files of the records iterated by RecordIterator,
+	 * sorted by localityCompare.
+	 *
+	 * The list is computed once per cache, or taken from the derived index.
+	 */
+	const vector<pkgCache::VerFile*>& records();
 };
 
 // Sort a version list by package file locality
@@ -169,131 +361,576 @@ bool localityCompare(const pkgCache::VerFile* a, const pkgCache::VerFile* b)
    return a->File < b->File;
 }
 
-// Iterate records using the algorithm used by apt-cache dumpavail
-struct RecordIteratorImpl
+/**
+ * Read package records from the files referenced by the apt cache.
+ *
+ * Records are read through a buffer of Ept::Readahead bytes (1MiB by default,
+ * 0 or less disables it): when the requested record is not already buffered,
+ * the buffer is refilled with one sequential read that also covers the following
+ * records in the same file, and the kernel is asked to start fetching the
+ * ones after that.  When the records are read in locality order, this makes
+ * full scans bound by disk bandwidth instead of seek latency.
+ *
+ * readExact() reads only the requested record, for random access.
+ */
+struct RecordReader
 {
-	mutable int _ref;
-	AptImplementation& apt;
-	vector<pkgCache::VerFile*> vflist;
+	pkgCache& cache;
 	pkgCache::PkgFileIterator lastFile;
 	FileFd file;
-	size_t lastOffset;
+	size_t window;
+	vector<char> buffer;
+	// Offset in the file of the beginning of the buffer
+	unsigned long long bufferOffset;
+	// Number of valid bytes in the buffer
+	size_t bufferSize;
+
+	RecordReader(pkgCache& cache)
+		: cache(cache), window(0), bufferOffset(0), bufferSize(0)
+	{
+		// Negative values disable readahead like 0
+		int readahead = _config->FindI("Ept::Readahead", 1024 * 1024);
+		if (readahead > 0)
+			window = readahead;
+	}
 
-	RecordIteratorImpl(AptImplementation& apt) : _ref(0), apt(apt)
+	~RecordReader()
 	{
-		// We already have an estimate of how many versions we're about to find
-		vflist.reserve(apt.cache().HeaderP->PackageCount + 1);
+		if (file.IsOpen())
+			file.Close();
+	}
 
-		// Populate the vector of versions to print
-		for (pkgCache::PkgIterator pi = apt.cache().PkgBegin(); !pi.end(); ++pi)
-		{    
-			if (pi->VersionList == 0)
-				continue;
+	bool sameFile(const pkgCache::VerFile* a, const pkgCache::VerFile* b) const
+	{
+		return a->File == b->File;
+	}
 
-			/* Get the candidate version or fallback on the installed version,
-			 * as usual */
-			pkgCache::VerIterator vi = apt.policy().GetCandidateVer(pi);
-			if (vi.end() == true)
+	// End offset of the last record, starting from list[idx], that fits in the
+	// window starting at begin
+	unsigned long long windowEnd(const vector<pkgCache::VerFile*>& list, size_t idx, unsigned long long begin) const
+	{
+		unsigned long long res = begin;
+		for (size_t i = idx; i < list.size() && sameFile(list[i], list[idx]); ++i)
+		{
+			unsigned long long end = list[i]->Offset + list[i]->Size;
+			if (end < begin || end - begin > window)
+				break;
+			res = end;
+		}
+		return res;
+	}
+
+	// Make sure that file is the one containing the record for vf
+	void openFile(const pkgCache::VerFile* vf)
+	{
+		// We can't reuse the file that was already open: open the new one
+		if ((lastFile.Cache() == 0) || vf->File + cache.PkgFileP != lastFile)
+		{
+			lastFile = pkgCache::PkgFileIterator(cache, vf->File + cache.PkgFileP);
+			if (!lastFile.IsOk())
+				throw Exception(string("Reading the data record for a package from file ") + lastFile.FileName());
+			if (file.IsOpen())
+				file.Close();
+			if (!file.Open(lastFile.FileName(), FileFd::ReadOnly))
+				throw Exception(string("Opening file ") + lastFile.FileName());
+			bufferOffset = 0;
+			bufferSize = 0;
+		}
+	}
+
+	/**
+	 * Read the record for list[idx].
+	 *
+	 * list is expected to be sorted with localityCompare, and is used to
+	 * decide how much data to read ahead.
+	 */
+	string read(const vector<pkgCache::VerFile*>& list, size_t idx)
+	{
+		const pkgCache::VerFile* vf = list[idx];
+		openFile(vf);
+
+		unsigned long long begin = vf->Offset;
+		unsigned long long end = begin + vf->Size;
+		if (begin < bufferOffset || end > bufferOffset + bufferSize)
+		{
+			// Refill the buffer with this record and the ones that follow it
+			instrument::Latency latency(instrument::RecordReadLatency);
+			unsigned long long fill = max(end, windowEnd(list, idx, begin));
+			if (buffer.size() < fill - begin)
+				buffer.resize(fill - begin);
+
+			// Avoid a seek if we start where the last read ended
+			if (begin != bufferOffset + bufferSize || bufferSize == 0)
+			{
+				instrument::count(instrument::RecordSeek);
+				if (!file.Seek(begin))
+					throw Exception(string("Cannot seek to package record in file ") + lastFile.FileName());
+			} else
+				instrument::count(instrument::RecordSequentialRead);
+			instrument::count(instrument::RecordBytesRead, fill - begin);
+
+			if (!file.Read(buffer.data(), fill - begin))
+				throw Exception(string("Cannot read package record in file ") + lastFile.FileName());
+			bufferOffset = begin;
+			bufferSize = fill - begin;
+
+			// Ask the kernel to start reading the next window in the background
+			size_t next = idx;
+			while (next < list.size() && sameFile(list[next], vf) && list[next]->Offset + list[next]->Size <= fill)
+				++next;
+			if (window && next < list.size() && sameFile(list[next], vf))
 			{
-				if (pi->CurrentVer == 0)
-					continue;
-				vi = pi.CurrentVer();
+				unsigned long long ahead = windowEnd(list, next, list[next]->Offset);
+				posix_fadvise(file.Fd(), list[next]->Offset, ahead - list[next]->Offset, POSIX_FADV_WILLNEED);
 			}
+		}
 
-			// Choose a valid file that contains the record for this version
-			pkgCache::VerFileIterator vfi = vi.FileList();
-			for ( ; !vfi.end(); ++vfi)
-				if ((vfi.File()->Flags & pkgCache::Flag::NotSource) == 0)
-					break;
+		return string(buffer.data() + (begin - bufferOffset), vf->Size);
+	}
 
-			// Handle packages whose candidate version is currently installed
-			// from outside the archives (like from a locally built .deb
-			if (vfi.end() == true)
-			{
-				for (pkgCache::VerIterator cur = pi.VersionList(); cur.end() != true; cur++)
-				{
-					for (vfi = cur.FileList(); vfi.end() == false; vfi++)
-					{	 
-						if ((vfi.File()->Flags & pkgCache::Flag::NotSource) == 0)
-						{
-							vfi = vi.FileList();
-							break;
-						}
-					}
+	/// Read the record for vf, without reading ahead unless it is buffered
+	string readExact(const pkgCache::VerFile* vf)
+	{
+		openFile(vf);
+
+		unsigned long long begin = vf->Offset;
+		unsigned long long end = begin + vf->Size;
+		if (begin < bufferOffset || end > bufferOffset + bufferSize)
+		{
+			instrument::Latency latency(instrument::RecordReadLatency);
+			if (buffer.size() < vf->Size)
+				buffer.resize(vf->Size);
+			instrument::count(instrument::RecordSeek);
+			if (!file.Seek(begin))
+				throw Exception(string("Cannot seek to package record in file ") + lastFile.FileName());
+			instrument::count(instrument::RecordBytesRead, vf->Size);
+			if (!file.Read(buffer.data(), vf->Size))
+				throw Exception(string("Cannot read package record in file ") + lastFile.FileName());
+			bufferOffset = begin;
+			bufferSize = vf->Size;
+		}
+
+		return string(buffer.data() + (begin - bufferOffset), vf->Size);
+	}
+};
+
+// List the version files of the records to iterate, using the algorithm used
+// by apt-cache dumpavail.  candidate(pi) returns the candidate version of a
+// package.
+template<typename CANDIDATE>
+static void buildRecordList(pkgCache& cache, CANDIDATE candidate, vector<pkgCache::VerFile*>& vflist)
+{
+	// We already have an estimate of how many versions we're about to find
+	vflist.reserve(cache.HeaderP->PackageCount + 1);
+
+	// Populate the vector of versions to print
+	for (pkgCache::PkgIterator pi = cache.PkgBegin(); !pi.end(); ++pi)
+	{    
+		if (pi->VersionList == 0)
+			continue;
+
+		/* Get the candidate version or fallback on the installed version,
+		 * as usual */
+		pkgCache::VerIterator vi = candidate(pi);
+		if (vi.end() == true)
+		{
+			if (pi->CurrentVer == 0)
+				continue;
+			vi = pi.CurrentVer();
+		}
 
-					if (vfi.end() == false)
+		// Choose a valid file that contains the record for this version
+		pkgCache::VerFileIterator vfi = vi.FileList();
+		for ( ; !vfi.end(); ++vfi)
+			if ((vfi.File()->Flags & pkgCache::Flag::NotSource) == 0)
+				break;
+
+		// Handle packages whose candidate version is currently installed
+		// from outside the archives (like from a locally built .deb
+		if (vfi.end() == true)
+		{
+			for (pkgCache::VerIterator cur = pi.VersionList(); cur.end() != true; cur++)
+			{
+				for (vfi = cur.FileList(); vfi.end() == false; vfi++)
+				{	 
+					if ((vfi.File()->Flags & pkgCache::Flag::NotSource) == 0)
+					{
+						vfi = vi.FileList();
 						break;
+					}
 				}
+
+				if (vfi.end() == false)
+					break;
 			}
-			if (!vfi.end())
-				vflist.push_back(vfi);
 		}
+		if (!vfi.end())
+			vflist.push_back(vfi);
+	}
+
+	sort(vflist.begin(), vflist.end(), localityCompare);
+}
+
+namespace {
+
+const char derived_index_magic[8] = { 'E', 'P', 'T', 'D', 'R', 'V', 'D', 0 };
+const uint32_t derived_index_version = 2;
+
+// Marks a missing id in the derived index tables
+const uint32_t no_id = 0xffffffff;
+
+// FNV-1a hash of the apt configuration that affects the choice of candidate
+// versions, like the default release set with -t
+uint64_t hashPolicyConfig()
+{
+	string values[] = {
+		_config->Find("APT::Default-Release"),
+		_config->FindFile("Dir::Etc::preferences"),
+		_config->FindDir("Dir::Etc::preferencesparts"),
+	};
+	uint64_t res = 14695981039346656037ull;
+	for (const auto& v : values)
+		// Hash the terminating 0 too, to tell "ab", "" from "a", "b"
+		for (size_t i = 0; i <= v.size(); ++i)
+			res = (res ^ (unsigned char)v.c_str()[i]) * 1099511628211ull;
+	return res;
+}
+
+// Identify the apt cache and configuration a derived index was computed from
+struct DerivedIndexKey
+{
+	int64_t timestamp;
+	int64_t preferences_timestamp;
+	uint64_t policy_hash;
+	uint64_t package_count;
+	uint64_t version_count;
+	uint64_t verfile_count;
+	uint64_t packagefile_count;
+
+	DerivedIndexKey() { memset(this, 0, sizeof(*this)); }
+
+	DerivedIndexKey(AptImplementation& apt)
+	{
+		// Zero the padding too, since the struct is compared with memcmp
+		memset(this, 0, sizeof(*this));
+		timestamp = apt.m_open_timestamp;
+		time_t t1 = sys::timestamp(_config->FindFile("Dir::Etc::preferences"), 0);
+		time_t t2 = sys::timestamp(_config->FindDir("Dir::Etc::preferencesparts"), 0);
+		preferences_timestamp = t1 > t2 ? t1 : t2;
+		policy_hash = hashPolicyConfig();
+		const pkgCache::Header& h = *apt.cache().HeaderP;
+		package_count = h.PackageCount;
+		version_count = h.VersionCount;
+		verfile_count = h.VerFileCount;
+		packagefile_count = h.PackageFileCount;
+	}
+};
+
+struct DerivedIndexHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t reserved;
+	DerivedIndexKey key;
+	// Number of entries in the record list
+	uint64_t record_count;
+	// Number of slots in the name hash table, a power of two
+	uint64_t hash_size;
+};
+
+// FNV-1a hash of a package name
+uint32_t hashName(const char* name)
+{
+	uint32_t res = 2166136261u;
+	for ( ; *name; ++name)
+		res = (res ^ (unsigned char)*name) * 16777619u;
+	return res;
+}
+
+}
+
+bool DerivedIndex::attach(AptImplementation& apt, const char* data, size_t size)
+{
+	if (size < sizeof(DerivedIndexHeader))
+		return false;
+	const DerivedIndexHeader* h = reinterpret_cast<const DerivedIndexHeader*>(data);
+	DerivedIndexKey key(apt);
+	if (memcmp(h->magic, derived_index_magic, sizeof(derived_index_magic)) != 0
+			|| h->version != derived_index_version
+			|| memcmp(&h->key, &key, sizeof(key)) != 0)
+		return false;
 
-		//cerr << vflist.size() << " versions found" << endl;
+	// The hash table needs to be a power of two with at least one free slot,
+	// so that lookups terminate
+	if (h->hash_size == 0
+			|| (h->hash_size & (h->hash_size - 1)) != 0
+			|| h->hash_size <= key.package_count)
+		return false;
 
-		sort(vflist.begin(), vflist.end(), localityCompare);
+	// Check that the three arrays fill the image exactly, subtracting from
+	// the available space to avoid overflows
+	size_t avail = size - sizeof(DerivedIndexHeader);
+	if (avail % sizeof(uint32_t) != 0)
+		return false;
+	avail /= sizeof(uint32_t);
+	if (h->record_count > avail)
+		return false;
+	avail -= h->record_count;
+	if (key.package_count > avail)
+		return false;
+	avail -= key.package_count;
+	if (h->hash_size != avail)
+		return false;
+
+	const uint32_t* r = reinterpret_cast<const uint32_t*>(data + sizeof(DerivedIndexHeader));
+	const uint32_t* c = r + h->record_count;
+	const uint32_t* t = c + key.package_count;
+
+	// Make sure that no id points outside the apt cache
+	for (size_t i = 0; i < h->record_count; ++i)
+		if (r[i] >= key.verfile_count)
+			return false;
+	for (size_t i = 0; i < key.package_count; ++i)
+		if (c[i] != no_id && c[i] >= key.version_count)
+			return false;
+	for (size_t i = 0; i < h->hash_size; ++i)
+		if (t[i] != no_id && t[i] >= key.package_count)
+			return false;
+
+	header = h;
+	records = r;
+	candidates = c;
+	hash = t;
+	return true;
+}
 
-		//for (size_t i = 0; i < vflist.size(); ++i)
-		//{
-		//	pkgCache::PkgFileIterator fi(apt.cache(), vflist[i]->File + apt.cache().PkgFileP);
-		//	cerr << i << ": " << fi.FileName() << ":" << vflist[i]->Offset << "-" << vflist[i]->Size << endl;
-		//}
-		//cerr << "Done indexing." << endl;
+bool DerivedIndex::load(AptImplementation& apt, const std::string& pathname)
+{
+	if (!sys::exists(pathname))
+		return false;
+	try {
+		sys::File in(pathname, O_RDONLY);
+		struct stat st;
+		in.fstat(st);
+		if ((size_t)st.st_size < sizeof(DerivedIndexHeader))
+			return false;
+		sys::MMap m = in.mmap(st.st_size, PROT_READ, MAP_SHARED);
+		in.close();
+		if (!attach(apt, m, m.size()))
+			return false;
+		map = std::move(m);
+		return true;
+	} catch (std::exception&) {
+		// The file may be unreadable, or replaced while we open it: the
+		// caller then builds the index instead
+		return false;
 	}
+}
 
-	~RecordIteratorImpl()
+void DerivedIndex::save(const std::string& pathname) const
+{
+	std::string data;
+	if (!image.empty())
+		data = image;
+	else
+		data.assign(static_cast<const char*>(map), map.size());
+	try {
+		sys::write_file_atomically(pathname, data, 0644);
+	} catch (std::exception&) {
+		// We may not have write access to the apt cache directory
+	}
+}
+
+uint32_t DerivedIndex::findPackage(pkgCache& cache, const std::string& name) const
+{
+	size_t mask = header->hash_size - 1;
+	size_t slot = hashName(name.c_str()) & mask;
+	for (size_t i = 0; i < header->hash_size && hash[slot] != no_id; ++i, slot = (slot + 1) & mask)
+		if (name == pkgCache::PkgIterator(cache, cache.PkgP + hash[slot]).Name())
+			return hash[slot];
+	return no_id;
+}
+
+void DerivedIndex::build(AptImplementation& apt)
+{
+	pkgCache& cache = apt.cache();
+	DerivedIndexHeader h;
+	memset(&h, 0, sizeof(h));
+	memcpy(h.magic, derived_index_magic, sizeof(derived_index_magic));
+	h.version = derived_index_version;
+	h.key = DerivedIndexKey(apt);
+
+	// Candidate versions
+	vector<uint32_t> cand(h.key.package_count, no_id);
+	size_t names = 0;
+	for (pkgCache::PkgIterator pi = cache.PkgBegin(); !pi.end(); ++pi)
 	{
-		if (file.IsOpen())
-			file.Close();
+		++names;
+		if (pi->VersionList == 0)
+			continue;
+		pkgCache::VerIterator vi = apt.policyCandidate(pi);
+		if (!vi.end())
+			cand[(pkgCache::Package*)pi - cache.PkgP] = (pkgCache::Version*)vi - cache.VerP;
 	}
 
-	void ref() { ++_ref; }
-	bool unref() { return --_ref == 0; }
+	// Record list, reusing the candidates computed above
+	vector<pkgCache::VerFile*> vflist;
+	buildRecordList(cache, [&](pkgCache::PkgIterator& pi) {
+		uint32_t id = cand[(pkgCache::Package*)pi - cache.PkgP];
+		if (id == no_id)
+			return pkgCache::VerIterator(cache);
+		return pkgCache::VerIterator(cache, cache.VerP + id);
+	}, vflist);
+	h.record_count = vflist.size();
+
+	// Name hash, filled with the packages that FindPkg returns for their
+	// name, keeping it at most half full
+	h.hash_size = 1;
+	while (h.hash_size < names * 2)
+		h.hash_size <<= 1;
+	vector<uint32_t> table(h.hash_size, no_id);
+	size_t mask = h.hash_size - 1;
+	for (pkgCache::PkgIterator pi = cache.PkgBegin(); !pi.end(); ++pi)
+	{
+		if (cache.FindPkg(pi.Name()) != pi)
+			continue;
+		size_t slot = hashName(pi.Name()) & mask;
+		while (table[slot] != no_id)
+			slot = (slot + 1) & mask;
+		table[slot] = (pkgCache::Package*)pi - cache.PkgP;
+	}
 
-	size_t size() { return vflist.size(); }
+	image.clear();
+	image.reserve(sizeof(h) + (vflist.size() + cand.size() + table.size()) * sizeof(uint32_t));
+	image.append(reinterpret_cast<const char*>(&h), sizeof(h));
+	for (const auto& vf : vflist)
+	{
+		uint32_t id = vf - cache.VerFileP;
+		image.append(reinterpret_cast<const char*>(&id), sizeof(id));
+	}
+	image.append(reinterpret_cast<const char*>(cand.data()), cand.size() * sizeof(uint32_t));
+	image.append(reinterpret_cast<const char*>(table.data()), table.size() * sizeof(uint32_t));
 
-	string record(size_t idx)
+	if (!attach(apt, image.data(), image.size()))
+		throw Exception("building the ept index of the apt cache");
+}
+
+/**
+ * Pathname of the on-disk copy of the derived index, or the empty string if
+ * it should not be used.
+ *
+ * The index is enabled by the Ept::CacheDerivedData apt configuration
+ * option, and is stored as ept-derived.bin next to pkgcache.bin.
+ */
+static std::string derivedIndexPathname()
+{
+	if (!_config->FindB("Ept::CacheDerivedData", false))
+		return std::string();
+	std::string pkgcache = _config->FindFile("Dir::Cache::pkgcache");
+	if (pkgcache.empty())
+		return std::string();
+	return str::joinpath(str::dirname(pkgcache), "ept-derived.bin");
+}
+
+const DerivedIndex& AptImplementation::index()
+{
+	std::call_once(m_index_once, [this] {
+		std::string pathname = derivedIndexPathname();
+		if (pathname.empty())
+			return;
+		if (m_index.load(*this, pathname))
+			return;
+		m_index.build(*this);
+		m_index.save(pathname);
+	});
+	return m_index;
+}
+
+pkgCache::PkgIterator AptImplementation::findPkg(const std::string& name)
+{
+	instrument::count(instrument::FindPkg);
+	const DerivedIndex& idx = index();
+	if (idx.valid())
 	{
-		//cerr << "Access record " << idx << endl;
-		//cerr << "lastfile: " << (lastFile.Cache() != 0) << endl;
-		// We can't reuse the file that was already open: open the new one
-		if ((lastFile.Cache() == 0) || vflist[idx]->File + apt.cache().PkgFileP != lastFile)
-		{
-			//cerr << "Needs open/reopen" << endl;
-			lastFile = pkgCache::PkgFileIterator(apt.cache(), vflist[idx]->File + apt.cache().PkgFileP);
-			if (!lastFile.IsOk())
-				throw Exception(string("Reading the data record for a package from file ") + lastFile.FileName());
-			//cerr << "Ok for " << lastFile.FileName() << endl;
-			if (file.IsOpen())
-				file.Close();
-			if (!file.Open(lastFile.FileName(), FileFd::ReadOnly))
-				throw Exception(string("Opening file ") + lastFile.FileName());
-			//cerr << "Opened " << lastFile.FileName() << endl;
-			lastOffset = 0;
-		}
+		uint32_t id = idx.findPackage(cache(), name);
+		if (id != no_id)
+			return pkgCache::PkgIterator(cache(), cache().PkgP + id);
+	}
+	// Also handles names that are not in the index, like "name:arch"
+	return cache().FindPkg(name);
+}
 
-		//cerr << "Reading from " << lastFile.FileName() << ":" << vflist[idx]->Offset << "-" << vflist[idx]->Size << " (lastOffset: " << lastOffset << ")" << endl;
+pkgCache::VerIterator AptImplementation::candidate(pkgCache::PkgIterator& pi)
+{
+	const DerivedIndex& idx = index();
+	if (!idx.valid())
+		return policyCandidate(pi);
+	instrument::count(instrument::GetCandidateVer);
+	uint32_t id = idx.candidates[(pkgCache::Package*)pi - cache().PkgP];
+	if (id == no_id)
+		return pkgCache::VerIterator(cache());
+	return pkgCache::VerIterator(cache(), cache().VerP + id);
+}
 
-		// If we start near were we ended, avoid a seek and enlarge the read a bit
-		size_t slack = vflist[idx]->Offset - lastOffset;
-		//cerr << "Slack: " << slack << endl;
-		if (slack > 8)
+const vector<pkgCache::VerFile*>& AptImplementation::records()
+{
+	std::call_once(m_records_once, [this] {
+		const DerivedIndex& idx = index();
+		if (idx.valid())
 		{
-			//cerr << "Slack too big: seek to " << vflist[idx]->Offset << endl;
-			slack = 0;
-			if (!file.Seek(vflist[idx]->Offset))
-				throw Exception(string("Cannot seek to package record in file ") + lastFile.FileName());
-		}
+			m_records.reserve(idx.header->record_count);
+			for (size_t i = 0; i < idx.header->record_count; ++i)
+				m_records.push_back(cache().VerFileP + idx.records[i]);
+		} else
+			buildRecordList(cache(), [this](pkgCache::PkgIterator& pi) {
+				return policyCandidate(pi);
+			}, m_records);
+	});
+	return m_records;
+}
 
-		char buffer[vflist[idx]->Size + slack + 1];
-		if (!file.Read(buffer, vflist[idx]->Size + slack))
-			throw Exception(string("Cannot read package record in file ") + lastFile.FileName());
-		buffer[vflist[idx]->Size + slack] = '\n';
-		//cerr << "Data read (slack: " << slack << ")" << endl;
+// Iterate records sorted by locality
+struct RecordIteratorImpl
+{
+	mutable std::atomic<int> _ref;
+	AptImplementation& apt;
+	const vector<pkgCache::VerFile*>& vflist;
+	// Created on the first read
+	std::unique_ptr<RecordReader> m_reader;
+	// Position of the last record read by recordAt()
+	size_t last_at;
 
-		lastOffset = vflist[idx]->Offset + vflist[idx]->Size;
+	RecordIteratorImpl(AptImplementation& apt) : _ref(0), apt(apt), vflist(apt.records()), last_at((size_t)-1)
+	{
+	}
 
-		return string(buffer+slack, vflist[idx]->Size);
+	void ref() { ++_ref; }
+	bool unref() { return --_ref == 0; }
+
+	size_t size() { return vflist.size(); }
+
+	RecordReader& reader()
+	{
+		if (!m_reader)
+			m_reader.reset(new RecordReader(apt.cache()));
+		return *m_reader;
+	}
+
+	// Read a record while iterating, reading ahead the ones that follow
+	string record(size_t idx)
+	{
+		return reader().read(vflist, idx);
+	}
+
+	// Read a record by position, reading ahead only when the positions
+	// accessed are consecutive
+	string recordAt(size_t idx)
+	{
+		bool sequential = idx == last_at + 1;
+		last_at = idx;
+		if (sequential)
+			return reader().read(vflist, idx);
+		return reader().readExact(vflist[idx]);
 	}
 };
 
@@ -441,6 +1078,46 @@ bool Apt::RecordIterator::operator!=(const RecordIterator& ri) const
 }
 
 
+Apt::RecordRange::RecordRange(RecordIteratorImpl* impl, size_t first, size_t last)
+	: impl(impl), first(first), last(last)
+{
+	impl->ref();
+}
+Apt::RecordRange::RecordRange(const RecordRange& r)
+	: impl(r.impl), first(r.first), last(r.last)
+{
+	impl->ref();
+}
+Apt::RecordRange::~RecordRange()
+{
+	if (impl->unref())
+		delete impl;
+}
+Apt::RecordRange& Apt::RecordRange::operator=(const RecordRange& r)
+{
+	// Increment first, to avoid it reaching zero on assignment to self
+	r.impl->ref();
+	if (impl->unref())
+		delete impl;
+	impl = r.impl;
+	first = r.first;
+	last = r.last;
+	return *this;
+}
+std::string Apt::RecordRange::operator[](size_t idx) const
+{
+	if (idx >= size())
+		throw std::out_of_range("record index out of range");
+	return impl->recordAt(first + idx);
+}
+Apt::RecordRange Apt::RecordRange::subrange(size_t begin, size_t end) const
+{
+	if (begin > end || end > size())
+		throw std::out_of_range("record subrange out of range");
+	return RecordRange(impl, first + begin, first + end);
+}
+
+
 Apt::Apt() : impl(new AptImplementation()) {}
 Apt::~Apt() { delete impl; }
 
@@ -466,6 +1143,11 @@ Apt::record_iterator Apt::recordEnd() const
 	return Apt::RecordIterator();
 }
 
+Apt::RecordRange Apt::records() const
+{
+	return Apt::RecordRange(new RecordIteratorImpl(*impl), 0, impl->records().size());
+}
+
 size_t Apt::size() const
 {
    	return impl->cache().HeaderP->PackageCount;
@@ -478,13 +1160,13 @@ time_t Apt::timestamp()
 
 bool Apt::isValid(const std::string& pkg) const
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(pkg);
+	pkgCache::PkgIterator pi = impl->findPkg(pkg);
 	return !pi.end();
 }
 
 Version Apt::validate(const Version& ver) const
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(ver.name());
+	pkgCache::PkgIterator pi = impl->findPkg(ver.name());
 	if (pi.end()) return Version();
 	for (pkgCache::VerIterator vi = pi.VersionList(); !vi.end(); vi++)
 	{
@@ -498,16 +1180,16 @@ Version Apt::validate(const Version& ver) const
 
 Version Apt::candidateVersion(const std::string& pkg) const
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(pkg);
+	pkgCache::PkgIterator pi = impl->findPkg(pkg);
 	if (pi.end()) return Version();
-	pkgCache::VerIterator vi = impl->policy().GetCandidateVer(pi);
+	pkgCache::VerIterator vi = impl->candidate(pi);
 	if (vi.end()) return Version();
 	return Version(pkg, vi.VerStr());
 }
 
 Version Apt::installedVersion(const std::string& pkg) const
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(pkg);
+	pkgCache::PkgIterator pi = impl->findPkg(pkg);
 	if (pi.end()) return Version();
 	if (pi->CurrentVer == 0) return Version();
 	pkgCache::VerIterator vi = pi.CurrentVer();
@@ -517,10 +1199,10 @@ Version Apt::installedVersion(const std::string& pkg) const
 
 Version Apt::anyVersion(const std::string& pkg) const
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(pkg);
+	pkgCache::PkgIterator pi = impl->findPkg(pkg);
 	if (pi.end()) return Version();
 
-	pkgCache::VerIterator vi = impl->policy().GetCandidateVer(pi);
+	pkgCache::VerIterator vi = impl->candidate(pi);
 	if (vi.end())
 	{
 		if (pi->CurrentVer == 0) return Version();
@@ -532,7 +1214,7 @@ Version Apt::anyVersion(const std::string& pkg) const
 
 PackageState Apt::state(const std::string& pkg) const
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(pkg);
+	pkgCache::PkgIterator pi = impl->findPkg(pkg);
 	if (pi.end()) return PackageState();
 	pkgDepCache::StateCache sc = impl->depcache()[pi];
 
@@ -551,7 +1233,7 @@ PackageState Apt::state(const std::string& pkg) const
 			flags |= PackageState::Installed;
 
 			// Now check if it is upgradable
-			pkgCache::VerIterator cand = impl->policy().GetCandidateVer(pi);
+			pkgCache::VerIterator cand = impl->candidate(pi);
 
 			// If the candidate version is different than the installed one, then
 			// it is installable
@@ -584,10 +1266,12 @@ std::string Apt::rawRecord(const std::string& ver) const
 	return rawRecord(anyVersion(ver));
 }
 
-std::string Apt::rawRecord(const Version& ver) const
+// Find the version file with the record of a version, or 0 if the version is
+// not in the cache
+static pkgCache::VerFile* findVerFile(AptImplementation& apt, const Version& ver)
 {
-	pkgCache::PkgIterator pi = impl->cache().FindPkg(ver.name());
-	if (pi.end()) return std::string();
+	pkgCache::PkgIterator pi = apt.findPkg(ver.name());
+	if (pi.end()) return 0;
 	for (pkgCache::VerIterator vi = pi.VersionList(); !vi.end(); vi++)
 	{
 		const char* v = vi.VerStr();
@@ -603,31 +1287,93 @@ std::string Apt::rawRecord(const Version& ver) const
 					break;
 			if (vfi.end())
 				vfi = vi.FileList();
+			if (vfi.end())
+				return 0;
+			return vfi;
+		}
+	}
+	return 0;
+}
 
-			// Check and load the package list file
-			pkgCache::PkgFileIterator pfi = vfi.File();
-			if (!pfi.IsOk())
-				throw Exception(string("Reading the data record for a package version from file ") + pfi.FileName());
+std::string Apt::rawRecord(const Version& ver) const
+{
+	pkgCache::VerFile* vf = findVerFile(*impl, ver);
+	if (vf == 0) return std::string();
 
-			FileFd pkgf(pfi.FileName(), FileFd::ReadOnly);
-			if (_error->PendingError() == true)
-				return std::string();
+	RecordCache& cache = impl->m_record_cache;
+	{
+		std::lock_guard<std::mutex> lock(impl->m_record_cache_mutex);
+		if (cache.budget)
+			if (const std::string* res = cache.get(vf))
+				return *res;
+	}
 
-			// Read the record and then write it out again.
-			char* buffer = new char[vfi->Size+1];
-			buffer[vfi->Size] = '\n';
-			if (!pkgf.Seek(vfi->Offset) || !pkgf.Read(buffer, vfi->Size))
-			{
-				delete[] buffer;
-				return std::string();
-			}
+	// Check and load the package list file
+	pkgCache::PkgFileIterator pfi(impl->cache(), vf->File + impl->cache().PkgFileP);
+	if (!pfi.IsOk())
+		throw Exception(string("Reading the data record for a package version from file ") + pfi.FileName());
+
+	FileFd pkgf(pfi.FileName(), FileFd::ReadOnly);
+	if (_error->PendingError() == true)
+		return std::string();
+
+	// Read the record and then write it out again.
+	std::string res(vf->Size, 0);
+	if (!pkgf.Seek(vf->Offset) || !pkgf.Read(&res[0], vf->Size))
+		return std::string();
+	std::lock_guard<std::mutex> lock(impl->m_record_cache_mutex);
+	if (cache.budget)
+		cache.put(vf, res);
+	return res;
+}
 
-			std::string res(buffer, vfi->Size);
-			delete[] buffer;
-			return res;
+void Apt::rawRecords(const std::vector<Version>& vers, std::function<void(size_t, const std::string&)> out) const
+{
+	// Resolve the version files, remembering where they were requested
+	vector< pair<pkgCache::VerFile*, size_t> > found;
+	found.reserve(vers.size());
+	for (size_t i = 0; i < vers.size(); ++i)
+		if (pkgCache::VerFile* vf = findVerFile(*impl, vers[i]))
+			found.push_back(make_pair(vf, i));
+
+	// Read them in file order
+	stable_sort(found.begin(), found.end(),
+			[](const pair<pkgCache::VerFile*, size_t>& a, const pair<pkgCache::VerFile*, size_t>& b) {
+				return localityCompare(a.first, b.first);
+			});
+	vector<pkgCache::VerFile*> list;
+	list.reserve(found.size());
+	for (const auto& f : found)
+		list.push_back(f.first);
+
+	RecordReader reader(impl->cache());
+	for (size_t i = 0; i < list.size(); ++i)
+	{
+		string record;
+		try {
+			record = reader.read(list, i);
+		} catch (Exception&) {
+			// Like rawRecord(), give an empty record if the package list
+			// cannot be read
 		}
+		out(found[i].second, record);
 	}
-	return std::string();
+}
+
+std::vector<std::string> Apt::rawRecords(const std::vector<Version>& vers) const
+{
+	std::vector<std::string> res(vers.size());
+	rawRecords(vers, [&](size_t idx, const std::string& record) { res[idx] = record; });
+	return res;
+}
+
+std::vector<std::string> Apt::rawRecords(const std::vector<std::string>& pkgs) const
+{
+	std::vector<Version> vers;
+	vers.reserve(pkgs.size());
+	for (const auto& pkg : pkgs)
+		vers.push_back(anyVersion(pkg));
+	return rawRecords(vers);
 }
 
 
@@ -642,11 +1388,36 @@ void Apt::checkCacheUpdates()
 	if (impl->m_open_timestamp < timestamp())
 	{
 		// Crudely reopen everything
+		size_t record_cache_size = impl->m_record_cache.budget;
 		delete impl;
-		impl = new AptImplementation;
+		impl = new AptImplementation(record_cache_size);
 	}
 }
 
+void Apt::setRecordCacheSize(size_t bytes)
+{
+	std::lock_guard<std::mutex> lock(impl->m_record_cache_mutex);
+	impl->m_record_cache.resize(bytes);
+}
+
+Apt::RecordCacheStats Apt::recordCacheStats() const
+{
+	std::lock_guard<std::mutex> lock(impl->m_record_cache_mutex);
+	const RecordCache& cache = impl->m_record_cache;
+	RecordCacheStats res;
+	res.hits = cache.hits;
+	res.misses = cache.misses;
+	res.entries = cache.entries.size();
+	res.bytes = cache.bytes;
+	res.budget = cache.budget;
+	return res;
+}
+
+const timings::PhaseTimings& Apt::startupTimings() const
+{
+	return impl->m_timings;
+}
+
 void Apt::invalidateTimestamp()
 {
 	impl->m_open_timestamp = 0;
@@ -25,8 +25,11 @@
  */
 
 #include <ept/apt/version.h>
+#include <ept/utils/timings.h>
 #include <iterator>
 #include <stdexcept>
+#include <functional>
+#include <vector>
 
 class pkgCache;
 
@@ -116,6 +119,25 @@ protected:
  * framework.
  *
  * This class wraps the Apt cache and allows to query it in various ways.
+ *
+ * If Ept::CacheDerivedData is set in the apt configuration, data that is
+ * expensive to derive from the apt cache (the sorted list of records, the
+ * candidate version of each package and a package name index) is saved as
+ * ept-derived.bin next to pkgcache.bin.  Other processes map it in memory
+ * instead of computing it again, as long as the apt cache, the apt
+ * preferences and the configuration that affects candidate versions (like
+ * APT::Default-Release) are unchanged.
+ *
+ * Once constructed, an Apt object is read-only, and all its const methods
+ * can be called concurrently from different threads: the data that is
+ * computed lazily is initialised only once, and the record cache is
+ * protected by a lock.  checkCacheUpdates(), invalidateTimestamp() and
+ * setRecordCacheSize() are the exception, and must not run while other
+ * threads use the object.
+ *
+ * Record iterators and ranges share an unlocked read buffer with their
+ * copies and subranges: every thread should get its own from recordBegin()
+ * or records().
  */
 class Apt
 {
@@ -184,6 +206,59 @@ public:
 		friend class Apt;
 	};
 
+	/**
+	 * Random access range of package records, in the same order as
+	 * RecordIterator.
+	 *
+	 * Records are only read when accessed, so a range can be cheaply split in
+	 * subranges, for example to shard a scan or to binary search it.
+	 *
+	 * Copies of a range and their subranges share the same file reader: to
+	 * scan from multiple threads, use one range per thread obtained from
+	 * Apt::records().
+	 */
+	class RecordRange
+	{
+		RecordIteratorImpl* impl;
+		size_t first;
+		size_t last;
+
+	protected:
+		RecordRange(RecordIteratorImpl* impl, size_t first, size_t last);
+
+	public:
+		RecordRange(const RecordRange& r);
+		~RecordRange();
+		RecordRange& operator=(const RecordRange& r);
+
+		/// Return the number of records in the range
+		size_t size() const { return last - first; }
+
+		/// Return true if the range has no records
+		bool empty() const { return first == last; }
+
+		/**
+		 * Read the record at the given position in the range.
+		 *
+		 * Only the record itself is read, unless the previous access was to
+		 * the record just before it: then the following records are read
+		 * ahead as with RecordIterator.
+		 *
+		 * @throws std::out_of_range if idx is not less than size()
+		 */
+		std::string operator[](size_t idx) const;
+
+		/**
+		 * Return the records from position begin (included) to end
+		 * (excluded) of this range
+		 *
+		 * @throws std::out_of_range if the positions are outside the range
+		 */
+		RecordRange subrange(size_t begin, size_t end) const;
+
+		friend class Apt;
+	};
+
 	typedef Iterator iterator;
 	typedef RecordIterator record_iterator;
 
@@ -197,9 +272,23 @@ public:
 	iterator begin() const;
 	iterator end() const;
 
+	/**
+	 * Iterate the package records of all candidate versions, sorted by their
+	 * position in the package lists.
+	 *
+	 * Records are read in chunks of up to Ept::Readahead bytes from the apt
+	 * configuration (1MiB by default, 0 or less reads one record at a time), and the
+	 * following chunk is prefetched in the background.
+	 *
+	 * The sorted list of records is computed on first use and shared by all
+	 * iterators until the apt cache changes.
+	 */
 	record_iterator recordBegin() const;
 	record_iterator recordEnd() const;
 
+	/// Return a random access range with the same records as recordBegin()
+	RecordRange records() const;
+
 
 	/// Return the number of packages in the archive
 	size_t size() const;
@@ -253,6 +342,70 @@ public:
 	/// Get the raw package record for the given Version
 	std::string rawRecord(const Version& ver) const;
 
+	/**
+	 * Get the raw package records for many versions at once.
+	 *
+	 * The records are read in the order they appear in the package lists,
+	 * opening each list only once, which is much faster than calling
+	 * rawRecord() for each version.
+	 *
+	 * @return the records in the same order as \a vers.  Versions that
+	 * cannot be found, or whose package list cannot be read, give empty
+	 * strings, like in rawRecord().
+	 */
+	std::vector<std::string> rawRecords(const std::vector<Version>& vers) const;
+
+	/// Get the raw package records of anyVersion() of many packages
+	std::vector<std::string> rawRecords(const std::vector<std::string>& pkgs) const;
+
+	/**
+	 * Get the raw package records for many versions at once, without
+	 * keeping them all in memory.
+	 *
+	 * out(idx, record) is called for each version that has been found, in
+	 * the order the records appear in the package lists, with the position
+	 * of the version in \a vers.  record is empty if the package list
+	 * cannot be read.
+	 */
+	void rawRecords(const std::vector<Version>& vers, std::function<void(size_t, const std::string&)> out) const;
+
+	/// Statistics about the raw record cache
+	struct RecordCacheStats
+	{
+		/// Number of rawRecord() calls served from the cache
+		size_t hits;
+		/// Number of rawRecord() calls that had to read the package lists
+		size_t misses;
+		/// Number of records in the cache
+		size_t entries;
+		/// Total size of the records in the cache
+		size_t bytes;
+		/// Maximum total size of the records in the cache
+		size_t budget;
+	};
+
+	/**
+	 * Set the maximum amount of memory used to cache the records returned by
+	 * rawRecord().
+	 *
+	 * When the cache is full, the least recently used records are dropped.
+	 * The default is the value of Ept::RecordCacheSize in the apt
+	 * configuration, or 0 to disable the cache.  The cache is emptied when
+	 * checkCacheUpdates() reopens the apt cache, while the size is kept.
+	 */
+	void setRecordCacheSize(size_t bytes);
+
+	/// Return statistics about the raw record cache
+	RecordCacheStats recordCacheStats() const;
+
+	/**
+	 * Return the time spent in each phase of opening the apt cache
+	 * (aptInit, ReadMainList, pkgMakeStatusCache and ReadPinFile).
+	 *
+	 * The timings are also printed to stderr if $EPT_PROFILE_STARTUP is set.
+	 */
+	const timings::PhaseTimings& startupTimings() const;
+
 	/// Returns the pointer to the internal libapt pkgCache object used.
 	const pkgCache* aptPkgCache() const;
 
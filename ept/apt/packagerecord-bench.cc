@@ -0,0 +1,80 @@
+/*
+ * Benchmarks for PackageRecord accessors
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "packagerecord.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::apt;
+
+namespace {
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("accessors", [](Bench& b) {
+            vector<string> records = read_records(BENCH_PACKAGES);
+            vector<PackageRecord> parsed(records.begin(), records.end());
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& r : parsed)
+                {
+                    total += r.package().size();
+                    total += r.version().size();
+                    total += r.section().size();
+                    total += r.installedSize();
+                    total += r.shortDescription().size();
+                }
+            });
+            b.items(parsed.size());
+        });
+
+        add_method("tag_set", [](Bench& b) {
+            vector<string> records = read_records(BENCH_PACKAGES);
+            vector<PackageRecord> parsed(records.begin(), records.end());
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& r : parsed)
+                    total += r.tag().size();
+            });
+            b.items(parsed.size());
+        });
+
+        add_method("tag_list", [](Bench& b) {
+            vector<string> records = read_records(BENCH_PACKAGES);
+            vector<PackageRecord> parsed(records.begin(), records.end());
+            TagList tags;
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& r : parsed)
+                {
+                    r.tag(tags);
+                    total += tags.size();
+                }
+            });
+            b.items(parsed.size());
+        });
+    }
+} benchmarks("apt_packagerecord");
+
+}
@@ -120,6 +120,36 @@ class Tests : public TestCase
             tags.insert("works-with::software:package");
             wassert(actual(p.tag()) == tags);
         });
+
+        add_method("tag_list", []() {
+            // Check that parsing tags into a TagList matches tag()
+            PackageRecord p(
+                "Package: apt\n"
+                "Tag: admin::package-management, protocol::{ftp,http,ipv6},\n"
+                " role::program, admin::package-management, works-with::software:package\n");
+
+            TagList tags;
+            wassert_true(p.tag(tags));
+            std::set<std::string> parsed;
+            for (size_t i = 0; i < tags.size(); ++i)
+                parsed.insert(tags.str(i));
+            wassert(actual(tags.size()) == 6u);
+            wassert(actual(parsed) == p.tag());
+            wassert(actual(tags.str(0)) == "admin::package-management");
+            wassert_true(tags.contains("protocol::http"));
+            wassert_false(tags.contains("protocol::"));
+
+            // Reusing the list replaces its contents
+            p.scan("Package: foo\nTag: use::{editing,viewing}\n");
+            wassert_true(p.tag(tags));
+            wassert(actual(tags.size()) == 2u);
+            wassert(actual(tags.str(0)) == "use::editing");
+            wassert(actual(tags.str(1)) == "use::viewing");
+
+            p.scan("Package: bar\n");
+            wassert_false(p.tag(tags));
+            wassert_true(tags.empty());
+        });
     }
 } tests("apt_packagerecord");
 
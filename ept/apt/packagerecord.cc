@@ -22,8 +22,10 @@
 
 #include <ept/apt/packagerecord.h>
 
+#include <algorithm>
 #include <cctype>
 #include <cstdlib>
+#include <cstring>
 
 //#include <iostream>
 
@@ -68,117 +70,144 @@ std::string PackageRecord::parseLongDescription(const std::string& def, const st
 
 namespace {
 
-struct Tagparser
+inline bool is_tag_separator(char c)
 {
-    set<string>& res;
-    string cur_tag;
-    bool has_braces;
-
-    Tagparser(set<string>& res) : res(res) {}
+    return c == ' ' || c == '\t' || c == '\n' || c == ',';
+}
 
-    void expand_tag_braces(const std::string& tag)
+/**
+ * Tokenize the contents of a Tag: field, expanding braces, and send each
+ * resulting tag to out.append(prefix, prefix_size, name, name_size).
+ *
+ * "protocol::{ftp,http}" is sent as ("protocol::", "ftp") and
+ * ("protocol::", "http"); tags without braces are sent with an empty prefix.
+ */
+template<typename OUT>
+void parse_tags(const char* s, size_t size, OUT& out)
+{
+    const char* end = s + size;
+    const char* c = s;
+    while (c != end)
     {
-        size_t begin = tag.find('{');
-        if (begin != string::npos)
+        if (is_tag_separator(*c))
         {
-            string prefix(tag, 0, begin);
-            ++begin;
-            size_t end;
-            while ((end = tag.find(',', begin)) != string::npos)
+            ++c;
+            continue;
+        }
+
+        // Find the end of the tag, ignoring separators inside braces
+        const char* begin = c;
+        const char* brace = 0;
+        bool in_braces = false;
+        for ( ; c != end; ++c)
+        {
+            if (in_braces)
+            {
+                if (*c == '}')
+                    in_braces = false;
+            }
+            else if (*c == '{')
             {
-                res.insert(prefix + tag.substr(begin, end-begin));
-                begin = end + 1;
+                if (!brace) brace = c;
+                in_braces = true;
             }
-            res.insert(prefix + tag.substr(begin, tag.size() - 1 - begin));
+            else if (is_tag_separator(*c))
+                break;
         }
+
+        if (!brace)
+        {
+            out.append(begin, 0, begin, c - begin);
+            continue;
+        }
+
+        // Expand the braces, assuming that the tag ends with the closing one
+        const char* last = c - 1;
+        const char* name = brace + 1;
+        for (const char* i = name; i < last; ++i)
+            if (*i == ',')
+            {
+                out.append(begin, brace - begin, name, i - name);
+                name = i + 1;
+            }
+        out.append(begin, brace - begin, name, last > name ? last - name : 0);
     }
+}
+
+struct TagSetOutput
+{
+    set<string>& res;
+
+    TagSetOutput(set<string>& res) : res(res) {}
 
-    void reset_tag()
+    void append(const char* prefix, size_t prefix_size, const char* name, size_t name_size)
     {
-        cur_tag.clear();
-        has_braces = false;
+        string tag;
+        tag.reserve(prefix_size + name_size);
+        tag.append(prefix, prefix_size);
+        tag.append(name, name_size);
+        res.insert(tag);
     }
+};
+
+struct TagSpanCompare
+{
+    const char* arena;
 
-    void have_tag()
+    TagSpanCompare(const char* arena) : arena(arena) {}
+
+    int compare(const std::pair<size_t, size_t>& a, const char* b, size_t b_size) const
     {
-        if (has_braces)
-            expand_tag_braces(cur_tag);
-        else
-            res.insert(cur_tag);
-        reset_tag();
+        int res = memcmp(arena + a.first, b, min(a.second, b_size));
+        if (res) return res;
+        if (a.second < b_size) return -1;
+        if (a.second > b_size) return 1;
+        return 0;
     }
 
-    void parse(const std::string& s)
+    bool operator()(const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) const
     {
-        enum State {
-            SEP,
-            TAG,
-            BRACES,
-        } state = SEP;
-
-        reset_tag();
-
-        // Tokenize, dealing with braces
-        for (string::const_iterator c = s.begin(); c != s.end();)
-        {
-            switch (state)
-            {
-                case SEP:
-                    switch (*c)
-                    {
-                        case ' ':
-                        case '\t':
-                        case '\n':
-                        case ',':
-                            ++c;
-                            break;
-                        default:
-                            state = TAG;
-                            break;
-                    }
-                    break;
-                case TAG:
-                    switch (*c)
-                    {
-                        case ' ':
-                        case '\t':
-                        case '\n':
-                        case ',':
-                            ++c;
-                            have_tag();
-                            state = SEP;
-                            break;
-                        case '{':
-                            cur_tag += *c;
-                            ++c;
-                            has_braces = true;
-                            state = BRACES;
-                            break;
-                        default:
-                            cur_tag += *c;
-                            ++c;
-                            break;
-                    }
-                    break;
-                case BRACES:
-                    cur_tag += *c;
-                    ++c;
-                    switch (*c)
-                    {
-                        case '}':
-                            state = TAG;
-                            break;
-                    }
-                    break;
-            }
-        }
-        if (!cur_tag.empty())
-            have_tag();
+        return compare(a, arena + b.first, b.second) < 0;
     }
 };
 
 }
 
+void TagList::append(const char* prefix, size_t prefix_size, const char* name, size_t name_size)
+{
+    spans.push_back(make_pair(arena.size(), prefix_size + name_size));
+    arena.append(prefix, prefix_size);
+    arena.append(name, name_size);
+}
+
+void TagList::normalise()
+{
+    TagSpanCompare cmp(arena.data());
+    sort(spans.begin(), spans.end(), cmp);
+    spans.erase(unique(spans.begin(), spans.end(),
+                [&](const std::pair<size_t, size_t>& a, const std::pair<size_t, size_t>& b) {
+                    return cmp.compare(a, arena.data() + b.first, b.second) == 0;
+                }), spans.end());
+}
+
+bool TagList::contains(const std::string& tag) const
+{
+    TagSpanCompare cmp(arena.data());
+    size_t begin = 0, end = spans.size();
+    while (begin < end)
+    {
+        size_t cur = (begin + end) / 2;
+        int res = cmp.compare(spans[cur], tag.data(), tag.size());
+        if (res == 0)
+            return true;
+        if (res < 0)
+            begin = cur + 1;
+        else
+            end = cur;
+    }
+    return false;
+}
+
 std::set<std::string> PackageRecord::parseTags(const std::set<std::string>& def, const std::string& str) const
 {
     if (str == string())
@@ -186,12 +215,26 @@ std::set<std::string> PackageRecord::parseTags(const std::set<std::string>& def,
 
     set<string> res;
 
-    Tagparser parser(res);
-    parser.parse(str);
+    TagSetOutput out(res);
+    parse_tags(str.data(), str.size(), out);
 
     return res;
 }
 
+bool PackageRecord::tag(TagList& out) const
+{
+    out.clear();
+
+    const char* data;
+    size_t size;
+    if (!lookup(index("Tag"), data, size))
+        return false;
+
+    parse_tags(data, size, out);
+    out.normalise();
+    return true;
+}
+
 }
 }
 
@@ -25,10 +25,57 @@
 
 #include <ept/apt/recordparser.h>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace ept {
 namespace apt {
 
+/**
+ * Reusable container for the tags of a package record.
+ *
+ * Tags are stored back to back in a scratch buffer and accessed by index,
+ * sorted and without duplicates.  clear() keeps the allocated memory, so
+ * reusing the same TagList to parse the tags of many records performs no
+ * heap allocation once the buffers have grown large enough.
+ */
+class TagList
+{
+	/// Storage for the text of all the tags
+	std::string arena;
+
+	/// Offset and length of each tag in arena
+	std::vector<std::pair<size_t, size_t>> spans;
+
+public:
+	/// Remove all tags, keeping the allocated memory
+	void clear() { arena.clear(); spans.clear(); }
+
+	/// Append the tag formed by prefix followed by name
+	void append(const char* prefix, size_t prefix_size, const char* name, size_t name_size);
+
+	/// Sort the tags and remove duplicates
+	void normalise();
+
+	/// Return the number of tags
+	size_t size() const { return spans.size(); }
+
+	/// Return true if there are no tags
+	bool empty() const { return spans.empty(); }
+
+	/// Return a pointer to the (not null terminated) text of a tag
+	const char* data(size_t idx) const { return arena.data() + spans[idx].first; }
+
+	/// Return the length of the text of a tag
+	size_t length(size_t idx) const { return spans[idx].second; }
+
+	/// Return a copy of a tag as a std::string
+	std::string str(size_t idx) const { return arena.substr(spans[idx].first, spans[idx].second); }
+
+	/// Check if the list contains the given tag
+	bool contains(const std::string& tag) const;
+};
+
 /**
  * RecordParser specialised with access methods for common Debian package
  * information.
@@ -167,6 +214,14 @@ public:
 	{
 		return parseTags(def, lookup("Tag"));
 	}
+
+	/**
+	 * Parse the tags of the package into \a out, replacing its previous
+	 * contents.
+	 *
+	 * @return false if the record has no Tag: field
+	 */
+	bool tag(TagList& out) const;
 };
 
 }
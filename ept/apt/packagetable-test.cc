@@ -0,0 +1,123 @@
+#include "ept/test.h"
+#include "packagetable.h"
+#include <vector>
+#include <cstring>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::apt;
+
+namespace {
+
+vector<string> test_records()
+{
+    vector<string> res;
+    res.push_back(
+        "Package: apt\n"
+        "Section: admin\n"
+        "Installed-Size: 4368\n"
+        "Maintainer: APT Development Team <deity@lists.debian.org>\n"
+        "Version: 0.6.46.4-0.1\n"
+        "Size: 1436478\n");
+    res.push_back(
+        "Package: debtags\n"
+        "Section: admin\n"
+        "Installed-Size: 100\n"
+        "Maintainer: Enrico Zini <enrico@debian.org>\n"
+        "Version: 1.7\n"
+        "Size: 1000\n");
+    res.push_back(
+        "Package: sp\n"
+        "Section: text\n"
+        "Installed-Size: 20\n"
+        "Version: 1.3.4-1.2.1-47\n");
+    return res;
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("build", []() {
+            PackageTableBuilder builder(2);
+            builder.add(test_records());
+            PackageTable table = builder.build();
+            wassert(actual(builder.size()) == 0u);
+
+            wassert(actual(table.size()) == 3u);
+            wassert(actual(table.get(PackageTable::PackageName, 0)) == "apt");
+            wassert(actual(table.get(PackageTable::PackageName, 2)) == "sp");
+            wassert(actual(table.get(PackageTable::PackageVersion, 1)) == "1.7");
+            wassert(actual(table.get(PackageTable::Maintainer, 2)) == "");
+            wassert(actual(table.get(PackageTable::InstalledSize, 0)) == 4368u);
+            wassert(actual(table.get(PackageTable::PackageSize, 2)) == 0u);
+
+            // Dictionaries are sorted and deduplicated
+            wassert(actual(table.dictionarySize(PackageTable::Section)) == 2u);
+            wassert(actual(table.dictionary(PackageTable::Section, 0)) == "admin");
+            wassert(actual(table.dictionary(PackageTable::Section, 1)) == "text");
+            uint32_t code;
+            wassert_true(table.find(PackageTable::Section, "text", code));
+            wassert(actual(code) == 1u);
+            wassert_false(table.find(PackageTable::Section, "games", code));
+        });
+
+        add_method("sum_by", []() {
+            PackageTableBuilder builder(1);
+            builder.add(test_records());
+            PackageTable table = builder.build();
+            vector<uint64_t> sums = table.sumBy(PackageTable::Section, PackageTable::InstalledSize);
+            wassert(actual(sums.size()) == 2u);
+            wassert(actual(sums[0]) == 4468u);
+            wassert(actual(sums[1]) == 20u);
+        });
+
+        add_method("write", []() {
+            PackageTableBuilder builder;
+            builder.add(test_records());
+            builder.build().write("packagetable.test");
+
+            PackageTable table("packagetable.test");
+            wassert(actual(table.size()) == 3u);
+            wassert(actual(table.get(PackageTable::PackageName, 1)) == "debtags");
+            wassert(actual(table.get(PackageTable::Section, 2)) == "text");
+            wassert(actual(table.get(PackageTable::PackageSize, 0)) == 1436478u);
+
+            sys::write_file("packagetable.test", "this is not a table, but it is long enough to contain the header. "
+                    "this is not a table, but it is long enough to contain the header. "
+                    "this is not a table, but it is long enough to contain the header. ");
+            wassert(actual_function([]() { PackageTable table("packagetable.test"); }).throws("signature"));
+            sys::unlink("packagetable.test");
+        });
+
+        add_method("corrupt", []() {
+            PackageTableBuilder builder;
+            builder.add(test_records());
+            builder.build().write("packagetable.test");
+            string image = sys::read_file("packagetable.test");
+
+            // Row count so large that multiplying it by the item size overflows
+            string bad = image;
+            uint64_t rows = (uint64_t)1 << 62;
+            memcpy(&bad[24], &rows, sizeof(rows));
+            sys::write_file("packagetable.test", bad);
+            wassert(actual_function([]() { PackageTable table("packagetable.test"); }).throws("truncated"));
+
+            // Package name code past the end of the dictionary
+            bad = image;
+            uint64_t codes;
+            memcpy(&codes, &bad[56], sizeof(codes));
+            uint32_t code = 3;
+            memcpy(&bad[codes], &code, sizeof(code));
+            sys::write_file("packagetable.test", bad);
+            wassert(actual_function([]() { PackageTable table("packagetable.test"); }).throws("invalid dictionary code"));
+
+            sys::unlink("packagetable.test");
+        });
+    }
+} tests("apt_packagetable");
+
+}
@@ -0,0 +1,380 @@
+/** \file
+ * Columnar table of package metadata
+ */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include <ept/apt/packagetable.h>
+#include <ept/apt/packagerecord.h>
+#include <ept/apt/apt.h>
+#include <ept/utils/parallel.h>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace ept {
+namespace apt {
+
+namespace {
+
+const char table_magic[8] = { 'E', 'P', 'T', 'C', 'O', 'L', 'S', 0 };
+const uint32_t table_version = 1;
+
+/// Number of records read from Apt before parsing them in parallel
+const size_t apt_batch_size = 4096;
+
+/// Record fields stored in the string columns, in column order
+const char* string_fields[PackageTable::string_column_count] = {
+	"Package", "Version", "Section", "Maintainer",
+};
+
+struct StringColumnHeader
+{
+	/// Number of distinct values
+	uint64_t dict_count;
+	/// Offset of the dict_count + 1 uint32_t offsets of each value in dict_data
+	uint64_t dict_offsets;
+	/// Offset of the concatenated text of all values
+	uint64_t dict_data;
+	/// Offset of the uint32_t code of each row
+	uint64_t codes;
+};
+
+/// Header at the beginning of a table image. All offsets are from its start
+struct TableHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t string_columns;
+	uint32_t int_columns;
+	uint32_t reserved;
+	uint64_t rows;
+	StringColumnHeader strings[PackageTable::string_column_count];
+	/// Offset of the uint64_t value of each row, for each integer column
+	uint64_t ints[PackageTable::int_column_count];
+};
+
+/// Append data to the image padding it to 8 bytes, and return its offset
+uint64_t append_aligned(string& image, const void* data, size_t size)
+{
+	uint64_t res = image.size();
+	image.append(static_cast<const char*>(data), size);
+	image.append((8 - image.size() % 8) % 8, '\0');
+	return res;
+}
+
+struct ParsedRow
+{
+	string strings[PackageTable::string_column_count];
+	uint64_t ints[PackageTable::int_column_count];
+};
+
+void parse_rows(const vector<string>& records, vector<ParsedRow>& rows, size_t begin, size_t end)
+{
+	PackageRecord rec;
+	for (size_t i = begin; i < end; ++i)
+	{
+		rec.scan(records[i]);
+		for (unsigned c = 0; c < PackageTable::string_column_count; ++c)
+		{
+			const char* data;
+			size_t size;
+			if (rec.lookup(rec.index(string_fields[c]), data, size))
+				rows[i].strings[c].assign(data, size);
+		}
+		rows[i].ints[PackageTable::InstalledSize] = rec.installedSize();
+		rows[i].ints[PackageTable::PackageSize] = rec.packageSize();
+	}
+}
+
+}
+
+PackageTable::PackageTable()
+	: map(MAP_FAILED, 0), base(0), base_size(0)
+{
+}
+
+PackageTable::PackageTable(const std::string& pathname)
+	: map(MAP_FAILED, 0), base(0), base_size(0)
+{
+	sys::File in(pathname, O_RDONLY);
+	struct stat st;
+	in.fstat(st);
+	if ((size_t)st.st_size < sizeof(TableHeader))
+		throw std::runtime_error(pathname + " is too small to be a package table");
+	map = in.mmap(st.st_size, PROT_READ, MAP_SHARED);
+	in.close();
+	attach(map, map.size());
+}
+
+PackageTable::PackageTable(PackageTable&& o)
+	: image(std::move(o.image)), map(std::move(o.map)), base(0), base_size(o.base_size)
+{
+	base = image.empty() ? static_cast<const char*>(map) : image.data();
+	o.base = 0;
+	o.base_size = 0;
+}
+
+PackageTable& PackageTable::operator=(PackageTable&& o)
+{
+	if (this == &o) return *this;
+	image = std::move(o.image);
+	map = std::move(o.map);
+	base = image.empty() ? static_cast<const char*>(map) : image.data();
+	base_size = o.base_size;
+	o.base = 0;
+	o.base_size = 0;
+	return *this;
+}
+
+void PackageTable::attach(const char* data, size_t size)
+{
+	if (size < sizeof(TableHeader))
+		throw std::runtime_error("package table image is truncated");
+	const TableHeader* h = reinterpret_cast<const TableHeader*>(data);
+	if (memcmp(h->magic, table_magic, sizeof(table_magic)) != 0)
+		throw std::runtime_error("package table image has an invalid signature");
+	if (h->version != table_version
+			|| h->string_columns != string_column_count
+			|| h->int_columns != int_column_count)
+		throw std::runtime_error("package table image has an unsupported format version");
+
+	// Check that an array of count items of the given size is aligned and
+	// inside the image, dividing to avoid overflows
+	auto check = [&](uint64_t offset, uint64_t count, size_t item_size) {
+		if (offset > size || offset % item_size != 0 || count > (size - offset) / item_size)
+			throw std::runtime_error("package table image is truncated");
+	};
+	for (unsigned c = 0; c < string_column_count; ++c)
+	{
+		const StringColumnHeader& s = h->strings[c];
+		if (s.dict_count >= size / sizeof(uint32_t))
+			throw std::runtime_error("package table image is truncated");
+		check(s.dict_offsets, s.dict_count + 1, sizeof(uint32_t));
+		check(s.codes, h->rows, sizeof(uint32_t));
+		const uint32_t* offsets = reinterpret_cast<const uint32_t*>(data + s.dict_offsets);
+		check(s.dict_data, offsets[s.dict_count], 1);
+
+		// Validate dictionaries and codes once here, so that lookups do not
+		// need to
+		for (uint64_t i = 0; i < s.dict_count; ++i)
+			if (offsets[i] > offsets[i + 1])
+				throw std::runtime_error("package table image has an invalid dictionary");
+		const uint32_t* codes = reinterpret_cast<const uint32_t*>(data + s.codes);
+		for (uint64_t i = 0; i < h->rows; ++i)
+			if (codes[i] >= s.dict_count)
+				throw std::runtime_error("package table image has an invalid dictionary code");
+	}
+	for (unsigned c = 0; c < int_column_count; ++c)
+		check(h->ints[c], h->rows, sizeof(uint64_t));
+
+	base = data;
+	base_size = size;
+}
+
+size_t PackageTable::size() const
+{
+	return at<TableHeader>(0)->rows;
+}
+
+size_t PackageTable::dictionarySize(StringColumn col) const
+{
+	return at<TableHeader>(0)->strings[col].dict_count;
+}
+
+std::string PackageTable::dictionary(StringColumn col, uint32_t code) const
+{
+	const StringColumnHeader& s = at<TableHeader>(0)->strings[col];
+	const uint32_t* offsets = at<uint32_t>(s.dict_offsets);
+	return string(at<char>(s.dict_data) + offsets[code], offsets[code + 1] - offsets[code]);
+}
+
+bool PackageTable::find(StringColumn col, const std::string& value, uint32_t& code) const
+{
+	const StringColumnHeader& s = at<TableHeader>(0)->strings[col];
+	const uint32_t* offsets = at<uint32_t>(s.dict_offsets);
+	const char* data = at<char>(s.dict_data);
+
+	// Binary search the sorted dictionary
+	size_t begin = 0, end = s.dict_count;
+	while (begin < end)
+	{
+		size_t cur = (begin + end) / 2;
+		size_t len = offsets[cur + 1] - offsets[cur];
+		int res = memcmp(data + offsets[cur], value.data(), min(len, value.size()));
+		if (res == 0)
+			res = len < value.size() ? -1 : (len > value.size() ? 1 : 0);
+		if (res == 0)
+		{
+			code = cur;
+			return true;
+		}
+		if (res < 0)
+			begin = cur + 1;
+		else
+			end = cur;
+	}
+	return false;
+}
+
+const uint32_t* PackageTable::codes(StringColumn col) const
+{
+	return at<uint32_t>(at<TableHeader>(0)->strings[col].codes);
+}
+
+const uint64_t* PackageTable::values(IntColumn col) const
+{
+	return at<uint64_t>(at<TableHeader>(0)->ints[col]);
+}
+
+std::vector<uint64_t> PackageTable::sumBy(StringColumn key, IntColumn value) const
+{
+	vector<uint64_t> res(dictionarySize(key), 0);
+	const uint32_t* k = codes(key);
+	const uint64_t* v = values(value);
+	size_t rows = size();
+	for (size_t i = 0; i < rows; ++i)
+		res[k[i]] += v[i];
+	return res;
+}
+
+void PackageTable::write(const std::string& pathname) const
+{
+	sys::write_file_atomically(pathname, string(base, base_size), 0666);
+}
+
+
+PackageTableBuilder::PackageTableBuilder(unsigned threads)
+	: threads(threads)
+{
+}
+
+void PackageTableBuilder::add(const std::vector<std::string>& records)
+{
+	// Parse all records in parallel
+	vector<ParsedRow> rows(records.size());
+	parallel::run(parallel::Partition(records.size(), threads, 256), [&](size_t, size_t begin, size_t end) {
+		parse_rows(records, rows, begin, end);
+	});
+
+	// Append them in order, encoding the strings
+	for (const auto& row : rows)
+	{
+		for (unsigned c = 0; c < PackageTable::string_column_count; ++c)
+		{
+			auto res = dict_index[c].insert(make_pair(row.strings[c], (uint32_t)dict_values[c].size()));
+			if (res.second)
+				dict_values[c].push_back(row.strings[c]);
+			codes[c].push_back(res.first->second);
+		}
+		for (unsigned c = 0; c < PackageTable::int_column_count; ++c)
+			ints[c].push_back(row.ints[c]);
+	}
+}
+
+void PackageTableBuilder::add(const Apt& apt)
+{
+	vector<string> batch;
+	batch.reserve(apt_batch_size);
+	for (Apt::record_iterator i = apt.recordBegin(); i != apt.recordEnd(); ++i)
+	{
+		batch.push_back(*i);
+		if (batch.size() == apt_batch_size)
+		{
+			add(batch);
+			batch.clear();
+		}
+	}
+	if (!batch.empty())
+		add(batch);
+}
+
+PackageTable PackageTableBuilder::build()
+{
+	TableHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, table_magic, sizeof(table_magic));
+	header.version = table_version;
+	header.string_columns = PackageTable::string_column_count;
+	header.int_columns = PackageTable::int_column_count;
+	header.rows = size();
+
+	string image;
+	append_aligned(image, &header, sizeof(header));
+
+	for (unsigned c = 0; c < PackageTable::string_column_count; ++c)
+	{
+		const vector<string>& values = dict_values[c];
+
+		// Sort the dictionary, and compute the new code of each value
+		vector<uint32_t> order(values.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			order[i] = i;
+		sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return values[a] < values[b]; });
+		vector<uint32_t> remap(values.size());
+		for (size_t i = 0; i < order.size(); ++i)
+			remap[order[i]] = i;
+
+		vector<uint32_t> offsets;
+		offsets.reserve(values.size() + 1);
+		string data;
+		for (auto i : order)
+		{
+			offsets.push_back(data.size());
+			data += values[i];
+		}
+		offsets.push_back(data.size());
+
+		for (auto& code : codes[c])
+			code = remap[code];
+
+		header.strings[c].dict_count = values.size();
+		header.strings[c].dict_offsets = append_aligned(image, offsets.data(), offsets.size() * sizeof(uint32_t));
+		header.strings[c].dict_data = append_aligned(image, data.data(), data.size());
+		header.strings[c].codes = append_aligned(image, codes[c].data(), codes[c].size() * sizeof(uint32_t));
+	}
+
+	for (unsigned c = 0; c < PackageTable::int_column_count; ++c)
+		header.ints[c] = append_aligned(image, ints[c].data(), ints[c].size() * sizeof(uint64_t));
+
+	memcpy(&image[0], &header, sizeof(header));
+
+	// Reset the builder
+	for (unsigned c = 0; c < PackageTable::string_column_count; ++c)
+	{
+		dict_index[c].clear();
+		dict_values[c].clear();
+		codes[c].clear();
+	}
+	for (unsigned c = 0; c < PackageTable::int_column_count; ++c)
+		ints[c].clear();
+
+	PackageTable res;
+	res.image = std::move(image);
+	res.attach(res.image.data(), res.image.size());
+	return res;
+}
+
+}
+}
+
+// vim:set ts=4 sw=4:
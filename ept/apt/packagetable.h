@@ -0,0 +1,197 @@
+#ifndef EPT_APT_PACKAGETABLE_H
+#define EPT_APT_PACKAGETABLE_H
+
+/** \file
+ * Columnar table of package metadata
+ */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include <ept/utils/sys.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+
+namespace ept {
+namespace apt {
+
+class Apt;
+class PackageTableBuilder;
+
+/**
+ * Read-only columnar table with commonly queried fields of all the package
+ * records in an archive.
+ *
+ * String columns are dictionary encoded: each row stores a 32 bit code
+ * indexing a sorted dictionary of the distinct values of the column, so that
+ * codes sort like the strings they stand for.  Integer columns are stored as
+ * arrays of 64 bit values.
+ *
+ * All the data lives in a single contiguous image, with the same layout in
+ * memory and on disk: a table saved with write() can be mapped back in
+ * memory by the PackageTable(pathname) constructor.  The on-disk format uses
+ * the native byte order and is not portable across architectures.
+ */
+class PackageTable
+{
+public:
+	/// Dictionary encoded string columns
+	enum StringColumn {
+		PackageName,
+		PackageVersion,
+		Section,
+		Maintainer,
+	};
+	static const unsigned string_column_count = 4;
+
+	/// Integer columns
+	enum IntColumn {
+		InstalledSize,
+		PackageSize,
+	};
+	static const unsigned int_column_count = 2;
+
+protected:
+	/// Image storage, when the table has been built in memory
+	std::string image;
+
+	/// Image storage, when the table has been loaded from a file
+	sys::MMap map;
+
+	/// Start of the image
+	const char* base;
+
+	/// Size of the image
+	size_t base_size;
+
+	PackageTable();
+
+	/// Point base to the image storage and validate its contents
+	void attach(const char* data, size_t size);
+
+	template<typename T>
+	const T* at(uint64_t offset) const { return reinterpret_cast<const T*>(base + offset); }
+
+public:
+	/**
+	 * Map a table previously saved with write()
+	 *
+	 * @throws std::runtime_error if the file is not a valid table
+	 */
+	explicit PackageTable(const std::string& pathname);
+	PackageTable(PackageTable&& o);
+	PackageTable(const PackageTable&) = delete;
+	PackageTable& operator=(PackageTable&& o);
+	PackageTable& operator=(const PackageTable&) = delete;
+
+	/// Return the number of rows
+	size_t size() const;
+
+	/// Return the number of distinct values in a string column
+	size_t dictionarySize(StringColumn col) const;
+
+	/// Return the dictionary value for a code
+	std::string dictionary(StringColumn col, uint32_t code) const;
+
+	/**
+	 * Look up the code of a string value.
+	 *
+	 * @return false if the value does not appear in the column
+	 */
+	bool find(StringColumn col, const std::string& value, uint32_t& code) const;
+
+	/// Return the array of size() dictionary codes of a string column
+	const uint32_t* codes(StringColumn col) const;
+
+	/// Return the array of size() values of an integer column
+	const uint64_t* values(IntColumn col) const;
+
+	/// Return the value of a string column for a row
+	std::string get(StringColumn col, size_t row) const { return dictionary(col, codes(col)[row]); }
+
+	/// Return the value of an integer column for a row
+	uint64_t get(IntColumn col, size_t row) const { return values(col)[row]; }
+
+	/**
+	 * Sum the values of an integer column grouping by the values of a string
+	 * column.
+	 *
+	 * @return a vector with one sum for each dictionary code of \a key
+	 */
+	std::vector<uint64_t> sumBy(StringColumn key, IntColumn value) const;
+
+	/// Atomically save the table to the given file
+	void write(const std::string& pathname) const;
+
+	friend class PackageTableBuilder;
+};
+
+/**
+ * Build a PackageTable from raw package records.
+ *
+ * Records are parsed in parallel by a pool of threads, then appended in
+ * order as rows of the table.
+ */
+class PackageTableBuilder
+{
+protected:
+	/// Number of parsing threads, or 0 for as many as the available cores
+	unsigned threads;
+
+	/// Map each distinct string to its unsorted code, for each string column
+	std::unordered_map<std::string, uint32_t> dict_index[PackageTable::string_column_count];
+
+	/// Distinct strings in order of appearance, for each string column
+	std::vector<std::string> dict_values[PackageTable::string_column_count];
+
+	/// Unsorted codes of each row, for each string column
+	std::vector<uint32_t> codes[PackageTable::string_column_count];
+
+	/// Values of each row, for each integer column
+	std::vector<uint64_t> ints[PackageTable::int_column_count];
+
+public:
+	/**
+	 * @param threads
+	 *   Number of threads used to parse records, or 0 to use as many as the
+	 *   available cores
+	 */
+	explicit PackageTableBuilder(unsigned threads = 0);
+
+	/// Parse raw package records and append them to the table
+	void add(const std::vector<std::string>& records);
+
+	/// Read and append all the records in the Apt cache
+	void add(const Apt& apt);
+
+	/// Return the number of rows added so far
+	size_t size() const { return ints[0].size(); }
+
+	/**
+	 * Build the table with all the rows added so far.
+	 *
+	 * The builder is left empty.
+	 */
+	PackageTable build();
+};
+
+}
+}
+
+// vim:set ts=4 sw=4:
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Benchmarks for scanning package records
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "recordparser.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::apt;
+
+namespace {
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("scan_packages", [](Bench& b) {
+            vector<string> records = read_records(BENCH_PACKAGES);
+            RecordParser parser;
+            b.run([&] {
+                for (const auto& r : records)
+                    parser.scan(r);
+            });
+            b.bytes(total_size(records));
+            b.items(records.size());
+        });
+
+        add_method("scan_status", [](Bench& b) {
+            vector<string> records = read_records(BENCH_STATUS);
+            RecordParser parser;
+            b.run([&] {
+                for (const auto& r : records)
+                    parser.scan(r);
+            });
+            b.bytes(total_size(records));
+            b.items(records.size());
+        });
+
+        add_method("lookup", [](Bench& b) {
+            vector<string> records = read_records(BENCH_PACKAGES);
+            vector<RecordParser> parsers(records.begin(), records.end());
+            size_t found = 0;
+            b.run([&] {
+                for (const auto& p : parsers)
+                    found += p.lookup("Description").size();
+            });
+            b.items(parsers.size());
+        });
+    }
+} benchmarks("apt_recordparser");
+
+}
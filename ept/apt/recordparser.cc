@@ -21,9 +21,11 @@
  */
 
 #include <ept/apt/recordparser.h>
+#include <ept/utils/instrument.h>
 
 #include <algorithm>
 #include <cctype>
+#include <cstring>
 
 //#include <iostream>
 
@@ -42,8 +44,21 @@ struct rpcompare
 	}
 };
 
+int RecordParser::compareName(size_t idx, const std::string& str) const
+{
+	size_t begin = idx == 0 ? 0 : ends[idx - 1];
+	size_t end = ends[idx];
+	if (const void* colon = memchr(buffer.data() + begin, ':', end - begin))
+		end = (const char*)colon - buffer.data();
+	return buffer.compare(begin, end - begin, str);
+}
+
 void RecordParser::scan(const std::string& str)
 {
+	instrument::Latency latency(instrument::RecordParseLatency);
+	instrument::count(instrument::RecordParse);
+	instrument::count(instrument::RecordParseBytes, str.size());
+
 	buffer = str;
 	ends.clear();
 	sorted.clear();
@@ -142,6 +157,26 @@ std::string RecordParser::lookup(size_t idx) const
 	return res;
 }
 
+bool RecordParser::lookup(size_t idx, const char*& data, size_t& size) const
+{
+	if (idx >= ends.size())
+		return false;
+	size_t begin = idx == 0 ? 0 : ends[idx - 1];
+	size_t end = ends[idx];
+	if (const void* colon = memchr(buffer.data() + begin, ':', end - begin))
+	{
+		// Skip initial whitespace after the :
+		for (begin = (const char*)colon - buffer.data() + 1; begin < end && isspace(buffer[begin]); ++begin)
+			;
+		// Trim spaces at the end
+		while (end > begin && isspace(buffer[end - 1]))
+			--end;
+	}
+	data = buffer.data() + begin;
+	size = end - begin;
+	return true;
+}
+
 size_t RecordParser::index(const std::string& str) const
 {
 	int begin, end;
@@ -152,13 +187,13 @@ size_t RecordParser::index(const std::string& str) const
 	{
 		int cur = (end + begin) / 2;
 		//cerr << "Test " << cur << " " << str << " < " << name(cur) << endl;
-		if (name(sorted[cur]) > str)
+		if (compareName(sorted[cur], str) > 0)
 			end = cur;
 		else
 			begin = cur;
 	}
 
-	if (begin == -1 || name(sorted[begin]) != str)
+	if (begin == -1 || compareName(sorted[begin], str) != 0)
 		return size();
 	else
 		return sorted[begin];
@@ -46,6 +46,9 @@ class RecordParser
 	/// Indexes on the ends vector, sorted by field name
 	std::vector<size_t> sorted;
 
+	/// Compare the name of a field with a string, without copying it
+	int compareName(size_t idx, const std::string& str) const;
+
 public:
 	RecordParser() {}
 	RecordParser(const std::string& str) { scan(str); }
@@ -72,6 +75,16 @@ public:
 	/// Return the content of a field by its name
 	std::string lookup(const std::string& name) const { return lookup(index(name)); }
 
+	/**
+	 * Locate the content of a field by its index, without copying it.
+	 *
+	 * data is set to point inside the record buffer, and stays valid until
+	 * the next call to scan().
+	 *
+	 * @return false if the field does not exist
+	 */
+	bool lookup(size_t idx, const char*& data, size_t& size) const;
+
 	/// Return the content of a field by its index
 	std::string operator[](size_t idx) const { return lookup(idx); }
 
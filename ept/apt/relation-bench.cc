@@ -0,0 +1,67 @@
+/*
+ * Benchmarks for parsing package relationship fields
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "relation.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::apt;
+
+namespace {
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("depends", [](Bench& b) {
+            vector<string> records = read_records(BENCH_PACKAGES);
+            size_t total = 0;
+            b.run([&] {
+                parseRelations(records.begin(), records.end(), "Depends",
+                        [&](const PackageRecord&, const RelationList& rels) { total += rels.size(); });
+            });
+            b.bytes(total_size(records));
+            b.items(records.size());
+        });
+
+        add_method("depends_field", [](Bench& b) {
+            // Parse the relations only, without scanning the records
+            vector<string> records = read_records(BENCH_PACKAGES);
+            vector<string> fields;
+            for (const auto& r : records)
+                fields.push_back(PackageRecord(r).depends());
+            RelationList rels;
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& f : fields)
+                {
+                    rels.parse(f);
+                    total += rels.size();
+                }
+            });
+            b.bytes(total_size(fields));
+            b.items(fields.size());
+        });
+    }
+} benchmarks("apt_relation");
+
+}
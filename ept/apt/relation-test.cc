@@ -0,0 +1,127 @@
+#include "ept/test.h"
+#include "relation.h"
+#include <vector>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::apt;
+
+namespace {
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("simple", []() {
+            RelationList rels;
+            rels.parse("libc6 (>= 2.3.5-1), libgcc1 (>= 1:4.1.1-12), debian-archive-keyring");
+            wassert(actual(rels.size()) == 3u);
+            wassert(actual(rels.groupCount()) == 3u);
+            wassert(actual(rels.name(0)) == "libc6");
+            wassert(actual(rels[0].op) == RelationList::GreaterEqual);
+            wassert(actual(rels.version(0)) == "2.3.5-1");
+            wassert(actual(rels.name(1)) == "libgcc1");
+            wassert(actual(rels.version(1)) == "1:4.1.1-12");
+            wassert(actual(rels.name(2)) == "debian-archive-keyring");
+            wassert(actual(rels[2].op) == RelationList::None);
+            wassert_true(rels[2].version.empty());
+        });
+
+        add_method("alternatives", []() {
+            RelationList rels;
+            rels.parse("aptitude | synaptic | gnome-apt | wajig, dpkg-dev,\n apt-doc|bzip2");
+            wassert(actual(rels.size()) == 7u);
+            wassert(actual(rels.groupCount()) == 3u);
+            wassert(actual(rels.groupBegin(0)) == 0u);
+            wassert(actual(rels.groupEnd(0)) == 4u);
+            wassert(actual(rels.groupBegin(1)) == 4u);
+            wassert(actual(rels.groupEnd(1)) == 5u);
+            wassert(actual(rels.groupBegin(2)) == 5u);
+            wassert(actual(rels.groupEnd(2)) == 7u);
+            wassert(actual(rels.name(3)) == "wajig");
+            wassert(actual(rels.name(6)) == "bzip2");
+        });
+
+        add_method("qualifiers", []() {
+            RelationList rels;
+            rels.parse("python3:any (<< 3.12), libfoo-dev (= 1.0) [amd64 !i386] <!nocheck>, bar (>>2), baz (<1)");
+            wassert(actual(rels.size()) == 4u);
+            wassert(actual(rels.name(0)) == "python3");
+            wassert(actual(rels.arch(0)) == "any");
+            wassert(actual(rels[0].op) == RelationList::Less);
+            wassert(actual(rels.version(0)) == "3.12");
+            wassert(actual(rels[1].op) == RelationList::Equal);
+            wassert(actual(rels.str(rels[1].restrictions)) == "amd64 !i386");
+            wassert(actual(rels[2].op) == RelationList::Greater);
+            wassert(actual(rels.version(2)) == "2");
+            wassert(actual(rels[3].op) == RelationList::LessEqual);
+            wassert(actual(RelationList::operatorName(rels[0].op)) == "<<");
+        });
+
+        add_method("malformed", []() {
+            RelationList rels;
+            wassert(actual_function([&]() { rels.parse("foo (>= 1.0"); }).throws("unterminated"));
+            wassert(actual_function([&]() { rels.parse("foo (~ 1.0)"); }).throws("operator"));
+            wassert(actual_function([&]() { rels.parse("foo [amd64"); }).throws("unterminated"));
+
+            string error;
+            wassert_false(rels.tryParse("foo (>= 1.0", &error));
+            wassert(actual(error).contains("unterminated"));
+            wassert_true(rels.empty());
+            wassert_true(rels.tryParse("foo (>= 1.0)", &error));
+            wassert(actual(rels.size()) == 1u);
+        });
+
+        add_method("records", []() {
+            vector<string> records;
+            records.push_back("Package: a\nDepends: b, c | d\n");
+            records.push_back("Package: b\n");
+            records.push_back("Package: c\nDepends: e (>= 1)\n");
+
+            vector<size_t> counts;
+            parseRelations(records.begin(), records.end(), "Depends",
+                    [&](const PackageRecord& rec, const RelationList& rels) {
+                        counts.push_back(rels.size());
+                    });
+            wassert(actual(counts.size()) == 3u);
+            wassert(actual(counts[0]) == 3u);
+            wassert(actual(counts[1]) == 0u);
+            wassert(actual(counts[2]) == 1u);
+        });
+
+        add_method("records_malformed", []() {
+            // A malformed field does not stop parsing the other records
+            vector<string> records;
+            records.push_back("Package: a\nDepends: b (>= 1\n");
+            records.push_back("Package: b\nDepends: c\n");
+            records.push_back("Package: c\nDepends: d (~ 1)\n");
+
+            vector<string> parsed;
+            vector<string> failed;
+            size_t errors = parseRelations(records.begin(), records.end(), "Depends",
+                    [&](const PackageRecord& rec, const RelationList& rels) {
+                        parsed.push_back(rec.package());
+                    },
+                    [&](const PackageRecord& rec, const std::runtime_error& e) {
+                        failed.push_back(rec.package());
+                    });
+            wassert(actual(errors) == 2u);
+            wassert(actual(parsed.size()) == 1u);
+            wassert(actual(parsed[0]) == "b");
+            wassert(actual(failed.size()) == 2u);
+            wassert(actual(failed[0]) == "a");
+            wassert(actual(failed[1]) == "c");
+
+            size_t count = 0;
+            errors = parseRelations(records.begin(), records.end(), "Depends",
+                    [&](const PackageRecord&, const RelationList&) { ++count; });
+            wassert(actual(errors) == 2u);
+            wassert(actual(count) == 1u);
+        });
+    }
+} tests("apt_relation");
+
+}
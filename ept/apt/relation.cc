@@ -0,0 +1,251 @@
+/** \file
+ * Parser for package relationship fields
+ */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include <ept/apt/relation.h>
+
+#include <stdexcept>
+
+using namespace std;
+
+namespace ept {
+namespace apt {
+
+namespace {
+
+inline bool is_space(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// Characters that end a package name, version or architecture qualifier
+inline bool is_delimiter(char c)
+{
+	switch (c)
+	{
+		case ' ': case '\t': case '\n': case '\r':
+		case ',': case '|': case ':':
+		case '(': case ')': case '[': case ']': case '<': case '>':
+			return true;
+		default:
+			return false;
+	}
+}
+
+struct RelationParser
+{
+	const string& buf;
+	size_t pos;
+
+	RelationParser(const string& buf) : buf(buf), pos(0) {}
+
+	bool eof() const { return pos >= buf.size(); }
+	char cur() const { return buf[pos]; }
+
+	void skip_spaces()
+	{
+		while (!eof() && is_space(cur()))
+			++pos;
+	}
+
+	RelationList::Span token()
+	{
+		RelationList::Span res;
+		res.offset = pos;
+		while (!eof() && !is_delimiter(cur()))
+			++pos;
+		res.size = pos - res.offset;
+		return res;
+	}
+
+	// Versions can contain ':', so they only end at spaces or ')'
+	RelationList::Span version()
+	{
+		RelationList::Span res;
+		res.offset = pos;
+		while (!eof() && !is_space(cur()) && cur() != ')')
+			++pos;
+		res.size = pos - res.offset;
+		return res;
+	}
+
+	// Span up to the closing character, which is consumed
+	RelationList::Span until(char end, const char* what)
+	{
+		RelationList::Span res;
+		res.offset = pos;
+		while (!eof() && cur() != end)
+			++pos;
+		if (eof())
+			throw std::runtime_error(string("unterminated ") + what + " in relationship field");
+		res.size = pos - res.offset;
+		++pos;
+		return res;
+	}
+
+	RelationList::Operator op()
+	{
+		if (eof())
+			throw std::runtime_error("missing version operator in relationship field");
+		char c = cur();
+		char n = pos + 1 < buf.size() ? buf[pos + 1] : 0;
+		switch (c)
+		{
+			case '<':
+				if (n == '<') { pos += 2; return RelationList::Less; }
+				if (n == '=') { pos += 2; return RelationList::LessEqual; }
+				++pos; return RelationList::LessEqual;
+			case '>':
+				if (n == '>') { pos += 2; return RelationList::Greater; }
+				if (n == '=') { pos += 2; return RelationList::GreaterEqual; }
+				++pos; return RelationList::GreaterEqual;
+			case '=':
+				++pos; return RelationList::Equal;
+			default:
+				throw std::runtime_error("invalid version operator in relationship field");
+		}
+	}
+
+	void relation(RelationList::Relation& rel)
+	{
+		rel.name = token();
+		if (rel.name.empty())
+			throw std::runtime_error("missing package name in relationship field");
+
+		if (!eof() && cur() == ':')
+		{
+			++pos;
+			rel.arch = token();
+		}
+
+		skip_spaces();
+		if (!eof() && cur() == '(')
+		{
+			++pos;
+			skip_spaces();
+			rel.op = op();
+			skip_spaces();
+			rel.version = version();
+			skip_spaces();
+			if (eof() || cur() != ')')
+				throw std::runtime_error("unterminated version in relationship field");
+			++pos;
+			skip_spaces();
+		}
+
+		if (!eof() && cur() == '[')
+		{
+			++pos;
+			rel.restrictions = until(']', "architecture list");
+			skip_spaces();
+		}
+
+		// Skip build profile restrictions
+		while (!eof() && cur() == '<')
+		{
+			++pos;
+			until('>', "build profile");
+			skip_spaces();
+		}
+	}
+};
+
+}
+
+void RelationList::parse(const char* s, size_t size)
+{
+	clear();
+	buffer.assign(s, size);
+
+	RelationParser parser(buffer);
+	bool new_group = true;
+	while (true)
+	{
+		parser.skip_spaces();
+		if (parser.eof())
+			break;
+
+		switch (parser.cur())
+		{
+			case ',':
+				// Also skips empty groups
+				++parser.pos;
+				new_group = true;
+				continue;
+			case '|':
+				++parser.pos;
+				continue;
+		}
+
+		if (new_group)
+		{
+			groups.push_back(relations.size());
+			new_group = false;
+		}
+		relations.push_back(Relation());
+		parser.relation(relations.back());
+
+		if (!parser.eof() && parser.cur() != ',' && parser.cur() != '|')
+			throw std::runtime_error("unexpected character after relation in relationship field");
+	}
+}
+
+bool RelationList::tryParse(const char* s, size_t size, std::string* error)
+{
+	try {
+		parse(s, size);
+		return true;
+	} catch (std::runtime_error& e) {
+		clear();
+		if (error)
+			*error = e.what();
+		return false;
+	}
+}
+
+bool RelationList::parse(const RecordParser& rec, const std::string& field)
+{
+	const char* data;
+	size_t size;
+	if (!rec.lookup(rec.index(field), data, size))
+	{
+		clear();
+		return false;
+	}
+	parse(data, size);
+	return true;
+}
+
+const char* RelationList::operatorName(Operator op)
+{
+	switch (op)
+	{
+		case Less: return "<<";
+		case LessEqual: return "<=";
+		case Equal: return "=";
+		case GreaterEqual: return ">=";
+		case Greater: return ">>";
+		default: return "";
+	}
+}
+
+}
+}
+
+// vim:set ts=4 sw=4:
@@ -0,0 +1,219 @@
+#ifndef EPT_APT_RELATION_H
+#define EPT_APT_RELATION_H
+
+/** \file
+ * Parser for package relationship fields
+ */
+
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include <ept/apt/packagerecord.h>
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+namespace ept {
+namespace apt {
+
+/**
+ * Parsed contents of a relationship field, like Depends:, Recommends: or
+ * Provides:.
+ *
+ * The field is stored flat: relations are numbered in order of appearance,
+ * and consecutive relations that are alternatives of each other (separated
+ * by '|') form a group.  Names, versions and architecture qualifiers are
+ * stored as spans inside a copy of the field text.
+ *
+ * Reusing the same RelationList to parse many fields performs no heap
+ * allocation once its buffers have grown large enough.
+ */
+class RelationList
+{
+public:
+	/// Version comparison operator of a relation
+	enum Operator {
+		None,
+		Less,			///< <<
+		LessEqual,		///< <= (or the obsolete <)
+		Equal,			///< =
+		GreaterEqual,	///< >= (or the obsolete >)
+		Greater			///< >>
+	};
+
+	/// Position of a part of the relation inside the field text
+	struct Span
+	{
+		size_t offset;
+		size_t size;
+
+		Span() : offset(0), size(0) {}
+		bool empty() const { return size == 0; }
+	};
+
+	/// One package in a relationship field
+	struct Relation
+	{
+		/// Package name
+		Span name;
+		/// Architecture qualifier following the name, as in "python:any"
+		Span arch;
+		/// Version operator, or None if the relation is not versioned
+		Operator op;
+		/// Version the package is compared to
+		Span version;
+		/// Contents of the [...] architecture restriction list
+		Span restrictions;
+
+		Relation() : op(None) {}
+	};
+
+protected:
+	/// Copy of the field text
+	std::string buffer;
+
+	/// All the relations in the field
+	std::vector<Relation> relations;
+
+	/// Index in relations of the first relation of each group
+	std::vector<size_t> groups;
+
+public:
+	/// Remove all relations, keeping the allocated memory
+	void clear() { buffer.clear(); relations.clear(); groups.clear(); }
+
+	/**
+	 * Parse the contents of a relationship field, replacing the previous
+	 * contents of the list.
+	 *
+	 * @throws std::runtime_error if the field is malformed
+	 */
+	void parse(const char* s, size_t size);
+
+	/// Parse the contents of a relationship field
+	void parse(const std::string& s) { parse(s.data(), s.size()); }
+
+	/**
+	 * Parse the contents of a relationship field, without throwing if it is
+	 * malformed.
+	 *
+	 * @return false, leaving the list empty and storing the reason in
+	 * \a error if it is not null, if the field is malformed
+	 */
+	bool tryParse(const char* s, size_t size, std::string* error = 0);
+
+	/// Parse the contents of a relationship field, without throwing
+	bool tryParse(const std::string& s, std::string* error = 0) { return tryParse(s.data(), s.size(), error); }
+
+	/**
+	 * Parse the field with the given name from a record.
+	 *
+	 * @return false, leaving the list empty, if the record does not have the
+	 * field
+	 */
+	bool parse(const RecordParser& rec, const std::string& field);
+
+	/// Return the total number of relations, counting all alternatives
+	size_t size() const { return relations.size(); }
+
+	/// Return true if there are no relations
+	bool empty() const { return relations.empty(); }
+
+	/// Return a relation by its index
+	const Relation& operator[](size_t idx) const { return relations[idx]; }
+
+	/// Return the number of groups of alternatives
+	size_t groupCount() const { return groups.size(); }
+
+	/// Index of the first relation in a group
+	size_t groupBegin(size_t group) const { return groups[group]; }
+
+	/// Index one past the last relation in a group
+	size_t groupEnd(size_t group) const
+	{
+		return group + 1 < groups.size() ? groups[group + 1] : relations.size();
+	}
+
+	/// Return a pointer to the (not null terminated) text of a span
+	const char* data(const Span& span) const { return buffer.data() + span.offset; }
+
+	/// Return a copy of the text of a span
+	std::string str(const Span& span) const { return buffer.substr(span.offset, span.size); }
+
+	/// Return the package name of a relation
+	std::string name(size_t idx) const { return str(relations[idx].name); }
+
+	/// Return the version of a relation
+	std::string version(size_t idx) const { return str(relations[idx].version); }
+
+	/// Return the architecture qualifier of a relation
+	std::string arch(size_t idx) const { return str(relations[idx].arch); }
+
+	/// Return the Debian syntax for an operator ("" for None)
+	static const char* operatorName(Operator op);
+};
+
+/**
+ * Parse a relationship field in all the records of a sequence of raw package
+ * records, such as the one returned by Apt::recordBegin() and
+ * Apt::recordEnd().
+ *
+ * fun(const PackageRecord&, const RelationList&) is called for each record
+ * whose field is well formed, with an empty list if the record does not have
+ * the field. err(const PackageRecord&, const std::runtime_error&) is called
+ * instead for each record whose field is malformed, and parsing goes on with
+ * the next record. The same parser buffers are reused for all records.
+ *
+ * @return the number of records whose field is malformed
+ */
+template<typename ITER, typename FUN, typename ERR>
+size_t parseRelations(ITER begin, ITER end, const std::string& field, FUN fun, ERR err)
+{
+	PackageRecord rec;
+	RelationList rels;
+	size_t errors = 0;
+	for ( ; begin != end; ++begin)
+	{
+		rec.scan(*begin);
+		try {
+			rels.parse(rec, field);
+		} catch (std::runtime_error& e) {
+			++errors;
+			err(rec, e);
+			continue;
+		}
+		fun(rec, rels);
+	}
+	return errors;
+}
+
+/**
+ * Parse a relationship field in all the records of a sequence of raw package
+ * records, skipping the records whose field is malformed.
+ *
+ * @return the number of records whose field is malformed
+ */
+template<typename ITER, typename FUN>
+size_t parseRelations(ITER begin, ITER end, const std::string& field, FUN fun)
+{
+	return parseRelations(begin, end, field, fun, [](const PackageRecord&, const std::runtime_error&) {});
+}
+
+}
+}
+
+// vim:set ts=4 sw=4:
+#endif
@@ -0,0 +1,65 @@
+/*
+ * Benchmarks for comparing and sorting versions
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "version.h"
+#include "packagerecord.h"
+#include <algorithm>
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::apt;
+
+namespace {
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("compare", [](Bench& b) {
+            // Compare versions of the same package name, to measure version
+            // comparison instead of name comparison
+            vector<Version> versions;
+            for (const auto& r : read_records(BENCH_PACKAGES))
+                versions.push_back(Version("pkg", PackageRecord(r).version()));
+            size_t less = 0;
+            b.run([&] {
+                for (size_t i = 1; i < versions.size(); ++i)
+                    if (versions[i - 1] < versions[i])
+                        ++less;
+            });
+            b.items(versions.size() - 1);
+        });
+
+        add_method("sort", [](Bench& b) {
+            vector<Version> versions;
+            for (const auto& r : read_records(BENCH_PACKAGES))
+                versions.push_back(Version("pkg", PackageRecord(r).version()));
+            b.run([&] {
+                vector<Version> sorted(versions);
+                std::sort(sorted.begin(), sorted.end());
+            });
+            b.items(versions.size());
+        });
+    }
+} benchmarks("apt_version");
+
+}
@@ -0,0 +1,52 @@
+#ifndef EPT_BENCH_H
+#define EPT_BENCH_H
+
+#include <ept/utils/benchmarks.h>
+#include <ept/utils/sys.h>
+#include <string>
+#include <vector>
+
+/*
+ * Data files set up by run-check in the current directory
+ */
+#define BENCH_PACKAGES "state/lists/wherever_debian_._Packages"
+#define BENCH_STATUS "dpkg-status"
+#define BENCH_TAGS "debtags/package-tags"
+#define BENCH_VOCABULARY "debtags/vocabulary"
+
+namespace ept {
+namespace benchmarks {
+
+/// Split a Packages or status file in its records
+inline std::vector<std::string> read_records(const std::string& pathname)
+{
+    std::string data = sys::read_file(pathname);
+    std::vector<std::string> res;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t end = data.find("\n\n", pos);
+        if (end == std::string::npos)
+            end = data.size();
+        else
+            end += 1;
+        if (end > pos + 1)
+            res.push_back(data.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    return res;
+}
+
+/// Return the total size of a list of strings
+inline size_t total_size(const std::vector<std::string>& strings)
+{
+    size_t res = 0;
+    for (const auto& s : strings)
+        res += s.size();
+    return res;
+}
+
+}
+}
+
+#endif
@@ -0,0 +1,139 @@
+#include "ept/test.h"
+#include "cardinalityindex.h"
+#include "fast.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+vector<string> names(const CardinalityIndex::Range& r)
+{
+    vector<string> res;
+    for (const auto& e: r)
+        res.push_back(e.tag);
+    return res;
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("queries", []() {
+            Fast coll;
+            coll.insert(set<string>{ "a", "b", "c", "d" }, "x");
+            coll.insert(set<string>{ "a", "b" }, "y");
+            coll.insert(set<string>{ "c", "d" }, "z");
+            coll.insert(set<string>{ "a" }, "w");
+
+            CardinalityIndex index(coll);
+            wassert(actual(index.size()) == 4u);
+
+            auto top = names(index.top(3));
+            wassert(actual(top.size()) == 3u);
+            wassert(actual(top[0]) == "x");
+            wassert(actual(top[1]) == "y");
+            wassert(actual(top[2]) == "z");
+            wassert(actual(index.top(10).size()) == 4u);
+
+            auto bottom = names(index.bottom(2));
+            wassert(actual(bottom.size()) == 2u);
+            wassert(actual(bottom[0]) == "z");
+            wassert(actual(bottom[1]) == "w");
+
+            wassert(actual(index.atLeast(2).size()) == 3u);
+            wassert(actual(index.atLeast(5).size()) == 0u);
+            wassert(actual(index.atLeast(0).size()) == 4u);
+            wassert(actual(names(index.lessThan(2))[0]) == "w");
+            wassert(actual(index.lessThan(5).size()) == 4u);
+
+            wassert(actual(index.percentile(0)) == 1u);
+            wassert(actual(index.percentile(25)) == 1u);
+            wassert(actual(index.percentile(50)) == 2u);
+            wassert(actual(index.percentile(75)) == 2u);
+            wassert(actual(index.percentile(100)) == 4u);
+            wassert(actual(index.percentile(-10)) == 1u);
+            wassert(actual(index.percentile(1e300)) == 4u);
+            wassert(actual(index.percentile(INFINITY)) == 4u);
+            wassert(actual_function([&]() { index.percentile(NAN); }).throws("not a number"));
+
+            Fast empty;
+            CardinalityIndex none(empty);
+            wassert_true(none.empty());
+            wassert(actual(none.top(3).size()) == 0u);
+            wassert(actual(none.percentile(50)) == 0u);
+        });
+
+        add_method("cache", []() {
+            Fast coll;
+            coll.insert(set<string>{ "a", "b" }, "x");
+            coll.insert(set<string>{ "a" }, "y");
+
+            auto index = coll.cardinalityIndex();
+            wassert_true(coll.cardinalityIndex() == index);
+            size_t card;
+            wassert(actual(coll.findTagWithMaxCardinality(card)) == "x");
+            wassert(actual(card) == 2u);
+
+            // Every change to the collection drops the cached index
+            coll.insert(set<string>{ "a", "b", "c" }, "y");
+            wassert(actual(coll.cardinalityIndex()->begin()->tag) == "y");
+            wassert(actual(coll.findTagWithMaxCardinality(card)) == "y");
+            wassert(actual(card) == 3u);
+
+            coll.removeTag("y");
+            wassert(actual(coll.cardinalityIndex()->size()) == 1u);
+            wassert(actual(coll.findTagWithMaxCardinality(card)) == "x");
+
+            coll.removeTagsWithCardinalityLessThan(3);
+            wassert_true(coll.cardinalityIndex()->empty());
+            wassert(actual(coll.findTagWithMaxCardinality(card)) == "");
+            wassert(actual(card) == 0u);
+
+            FastBuilder builder;
+            builder.add("a", "z");
+            builder.build(coll);
+            wassert(actual(coll.cardinalityIndex()->size()) == 1u);
+
+            // The old index is a snapshot and still works
+            wassert(actual(index->size()) == 2u);
+        });
+
+        add_method("compare", []() {
+            // Compare with sorting the tags of the test data
+            Fast coll;
+            load_test_tags(coll);
+
+            size_t card;
+            string max_tag = coll.findTagWithMaxCardinality(card);
+            auto index = coll.cardinalityIndex();
+            wassert(actual(index->begin()->tag) == max_tag);
+            wassert(actual(index->begin()->cardinality) == card);
+
+            vector<unsigned> cards;
+            for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+                cards.push_back(t->second.size());
+            sort(cards.begin(), cards.end());
+            wassert(actual(index->size()) == cards.size());
+            wassert(actual(index->percentile(50)) == cards[(cards.size() + 1) / 2 - 1]);
+            unsigned prev = card;
+            for (const auto& e: *index)
+            {
+                wassert(actual(e.cardinality) <= prev);
+                wassert(actual(e.cardinality) == coll.getItemsHavingTag(e.tag).size());
+                prev = e.cardinality;
+            }
+            wassert(actual(index->atLeast(10).size() + index->lessThan(10).size()) == cards.size());
+            for (const auto& e: index->lessThan(10))
+                wassert(actual(e.cardinality) < 10u);
+        });
+    }
+} test("debtags_coll_cardinalityindex");
+
+}
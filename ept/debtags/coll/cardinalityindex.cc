@@ -0,0 +1,79 @@
+/*
+ * Tags of a tag collection ordered by cardinality
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/cardinalityindex.h>
+#include <ept/debtags/coll/fast.h>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+CardinalityIndex::CardinalityIndex(const Fast& coll)
+{
+    entries.reserve(coll.tagCount());
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+        entries.push_back(Entry{ t->first, (unsigned)t->second.size() });
+    // Tags come sorted by name, so a stable sort keeps ties in name order
+    stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.cardinality > b.cardinality;
+    });
+}
+
+CardinalityIndex::Range CardinalityIndex::top(size_t k) const
+{
+    return Range(entries.begin(), entries.begin() + min(k, entries.size()));
+}
+
+CardinalityIndex::Range CardinalityIndex::bottom(size_t k) const
+{
+    return Range(entries.end() - min(k, entries.size()), entries.end());
+}
+
+CardinalityIndex::Range CardinalityIndex::atLeast(unsigned card) const
+{
+    auto last = partition_point(entries.begin(), entries.end(), [&](const Entry& e) { return e.cardinality >= card; });
+    return Range(entries.begin(), last);
+}
+
+CardinalityIndex::Range CardinalityIndex::lessThan(unsigned card) const
+{
+    return Range(atLeast(card).end(), entries.end());
+}
+
+unsigned CardinalityIndex::percentile(double percent) const
+{
+    if (std::isnan(percent))
+        throw std::runtime_error("percentile is not a number");
+    if (entries.empty())
+        return 0;
+    percent = max(0.0, min(100.0, percent));
+    // Rank in increasing order of cardinality, from 1
+    size_t rank = (size_t)ceil(percent / 100.0 * entries.size());
+    if (rank < 1) rank = 1;
+    if (rank > entries.size()) rank = entries.size();
+    return entries[entries.size() - rank].cardinality;
+}
+
+}
+}
+}
@@ -0,0 +1,115 @@
+#ifndef EPT_DEBTAGS_COLL_CARDINALITYINDEX_H
+#define EPT_DEBTAGS_COLL_CARDINALITYINDEX_H
+
+/** \file
+ * Tags of a tag collection ordered by cardinality
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <string>
+#include <vector>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/**
+ * Tags of a collection sorted by decreasing cardinality (number of items),
+ * then by name.
+ *
+ * Top-k, bottom-k, threshold and percentile queries are answered with a
+ * slice of the sorted array or a binary search.
+ *
+ * Once Fast::cardinalityIndex() has built one, Fast::findTagWithMaxCardinality()
+ * reads its first entry instead of scanning the tags.
+ */
+class CardinalityIndex
+{
+public:
+    struct Entry
+    {
+        std::string tag;
+        unsigned cardinality;
+    };
+
+    typedef std::vector<Entry>::const_iterator const_iterator;
+
+    /// Sequence of consecutive entries
+    class Range
+    {
+        const_iterator first;
+        const_iterator last;
+
+    public:
+        Range(const_iterator first, const_iterator last) : first(first), last(last) {}
+
+        const_iterator begin() const { return first; }
+        const_iterator end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+protected:
+    std::vector<Entry> entries;
+
+public:
+    /// Index the tags of \a coll
+    explicit CardinalityIndex(const Fast& coll);
+    CardinalityIndex(const CardinalityIndex&) = delete;
+    CardinalityIndex& operator=(const CardinalityIndex&) = delete;
+
+    /// Return the number of tags
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+
+    /// Iterate all tags, most frequent first
+    const_iterator begin() const { return entries.begin(); }
+    const_iterator end() const { return entries.end(); }
+
+    /// Return the \a k most frequent tags, most frequent first
+    Range top(size_t k) const;
+
+    /// Return the \a k least frequent tags, still most frequent first
+    Range bottom(size_t k) const;
+
+    /// Return the tags with at least \a card items, most frequent first
+    Range atLeast(unsigned card) const;
+
+    /// Return the tags with fewer than \a card items, most frequent first
+    Range lessThan(unsigned card) const;
+
+    /**
+     * Return the smallest cardinality such that at least \a percent percent
+     * of the tags have that many items or fewer (nearest rank method).
+     *
+     * percentile(50) is the median, percentile(100) the maximum, and
+     * percentile(0) the minimum cardinality. Returns 0 if there are no tags.
+     *
+     * Values of \a percent outside 0 to 100 are clamped to that range.
+     *
+     * @throws std::runtime_error if \a percent is NaN
+     */
+    unsigned percentile(double percent) const;
+};
+
+}
+}
+}
+#endif
@@ -0,0 +1,147 @@
+#include "ept/test.h"
+#include "expression.h"
+#include "postings.h"
+#include "fast.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+Fast sample()
+{
+    Fast coll;
+    coll.insert("a", set<string>{ "role::program", "interface::x11", "implemented-in::c" });
+    coll.insert("b", set<string>{ "role::program", "interface::commandline", "use::gameplaying" });
+    coll.insert("c", set<string>{ "role::program", "interface::commandline", "implemented-in::perl" });
+    coll.insert("d", set<string>{ "role::documentation" });
+    return coll;
+}
+
+bool parse_fails(const std::string& expr)
+{
+    try {
+        Expression e(expr);
+    } catch (std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("bitmap", []() {
+            Bitmap b(130);
+            wassert_true(b.none());
+            b.set(0); b.set(64); b.set(129);
+            wassert(actual(b.count()) == 3u);
+            wassert(actual(b.next(0)) == 0u);
+            wassert(actual(b.next(1)) == 64u);
+            wassert(actual(b.next(65)) == 129u);
+            wassert(actual(b.next(130)) == Bitmap::npos);
+            b.flip();
+            wassert(actual(b.count()) == 127u);
+            wassert_false(b.test(64));
+            wassert_true(b.test(63));
+            b.fill();
+            wassert(actual(b.count()) == 130u);
+        });
+
+        add_method("parse", []() {
+            wassert(actual(Expression("a").format()) == "a");
+            wassert(actual(Expression("a && b || c").format()) == "((a && b) || c)");
+            wassert(actual(Expression("a and (b or not c)").format()) == "(a && (b || !c))");
+            wassert(actual(Expression("!a&b|c").format()) == "((!a && b) || c)");
+            wassert(actual(Expression(" works-with::* ").format()) == "works-with::*");
+
+            wassert_true(parse_fails(""));
+            wassert_true(parse_fails("a &&"));
+            wassert_true(parse_fails("(a || b"));
+            wassert_true(parse_fails("a b"));
+            wassert_true(parse_fails("a )"));
+        });
+
+        add_method("match_tags", []() {
+            Expression e("role::program && (interface::x11 || interface::commandline) && !use::gameplaying");
+            wassert_true(e(set<string>{ "role::program", "interface::x11" }));
+            wassert_false(e(set<string>{ "role::program", "interface::x11", "use::gameplaying" }));
+            wassert_false(e(set<string>{ "interface::x11" }));
+
+            Expression w("implemented-in::*");
+            wassert_true(w(set<string>{ "implemented-in::c" }));
+            wassert_false(w(set<string>{ "interface::x11" }));
+        });
+
+        add_method("query", []() {
+            Fast coll = sample();
+            PostingIndex index(coll);
+            wassert(actual(index.itemCount()) == 4u);
+
+            auto res = Expression("role::program && (interface::x11 || interface::commandline) && !use::gameplaying").match(index);
+            wassert(actual(res.size()) == 2u);
+            wassert_true(res.items() == set<string>({ "a", "c" }));
+
+            wassert_true(Expression("implemented-in::*").match(index).items() == set<string>({ "a", "c" }));
+            wassert_true(Expression("!implemented-in::*").match(index).items() == set<string>({ "b", "d" }));
+            wassert_true(Expression("!role::program").match(index).items() == set<string>({ "d" }));
+            wassert_true(Expression("missing").match(index).empty());
+            wassert_true(Expression("missing || role::documentation").match(index).items() == set<string>{ "d" });
+            wassert(actual(Expression("!missing").match(index).size()) == 4u);
+
+            vector<string> items;
+            for (const auto& i: Expression("role::*").match(index))
+                items.push_back(i);
+            wassert(actual(items.size()) == 4u);
+            wassert(actual(items[0]) == "a");
+            wassert(actual(items[3]) == "d");
+        });
+
+        add_method("plan", []() {
+            Fast coll = sample();
+            PostingIndex index(coll);
+
+            // Most selective terms come first, negations last
+            Query q(Expression("!use::gameplaying && role::program && interface::commandline"), index);
+            wassert(actual(q.explain()) == "(interface::commandline[2] && role::program[3] && !use::gameplaying[1])");
+            wassert(actual(q.estimate()) == 2u);
+
+            Query w(Expression("implemented-in::* && !!role::program"), index);
+            wassert(actual(w.explain()) == "((implemented-in::c[1] || implemented-in::perl[1]) && role::program[3])");
+
+            Query n(Expression("role::program && missing"), index);
+            wassert(actual(n.explain()) == "none");
+        });
+
+        add_method("compare", []() {
+            // Compare with evaluating the expressions item by item on the test data
+            Fast coll;
+            load_test_tags(coll);
+            PostingIndex index(coll);
+
+            const char* exprs[] = {
+                "role::program && (interface::x11 || interface::commandline) && !use::gameplaying",
+                "implemented-in::*",
+                "!implemented-in::* && !role::program",
+                "use::* && (works-with::text || works-with::image) && !interface::x11",
+                "special::not-yet-tagged || suite::debian && !role::*",
+            };
+            for (const auto& e: exprs)
+            {
+                Expression expr(e);
+                set<string> expected;
+                for (const auto& i: coll)
+                    if (expr(i.second))
+                        expected.insert(i.first);
+                wassert_true(expr.match(index).items() == expected);
+            }
+        });
+    }
+} test("debtags_coll_expression");
+
+}
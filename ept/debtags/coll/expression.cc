@@ -0,0 +1,527 @@
+/*
+ * Boolean tag expressions
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/expression.h>
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include <fnmatch.h>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+namespace expression {
+
+/// Node of a parsed expression
+struct Node
+{
+    enum Type { TAG, PATTERN, NOT, AND, OR };
+
+    Type type;
+    std::string name;
+    std::vector<std::unique_ptr<Node>> children;
+
+    Node(Type type, const std::string& name = std::string()) : type(type), name(name) {}
+
+    bool match(const std::set<std::string>& tags) const
+    {
+        switch (type)
+        {
+            case TAG:
+                return tags.find(name) != tags.end();
+            case PATTERN:
+                for (const auto& t: tags)
+                    if (fnmatch(name.c_str(), t.c_str(), 0) == 0)
+                        return true;
+                return false;
+            case NOT:
+                return !children[0]->match(tags);
+            case AND:
+                for (const auto& c: children)
+                    if (!c->match(tags))
+                        return false;
+                return true;
+            case OR:
+                for (const auto& c: children)
+                    if (c->match(tags))
+                        return true;
+                return false;
+        }
+        return false;
+    }
+
+    std::string format() const
+    {
+        switch (type)
+        {
+            case TAG:
+            case PATTERN:
+                return name;
+            case NOT:
+                return "!" + children[0]->format();
+            default:
+            {
+                std::string res = "(";
+                for (const auto& c: children)
+                {
+                    if (res.size() > 1)
+                        res += type == AND ? " && " : " || ";
+                    res += c->format();
+                }
+                return res + ")";
+            }
+        }
+    }
+};
+
+/// Compiled form of a Node
+struct Plan
+{
+    enum Type { NONE, ALL, POSTINGS, NOT, AND, OR };
+
+    Type type;
+    std::string label;
+    const std::vector<uint32_t>* postings = nullptr;
+    /// Estimated number of matching items
+    size_t estimate = 0;
+    std::vector<std::unique_ptr<Plan>> children;
+
+    Plan(Type type, size_t estimate) : type(type), estimate(estimate) {}
+
+    std::string explain() const
+    {
+        switch (type)
+        {
+            case NONE: return "none";
+            case ALL: return "all";
+            case POSTINGS: return label + "[" + to_string(estimate) + "]";
+            case NOT: return "!" + children[0]->explain();
+            default:
+            {
+                std::string res = "(";
+                for (const auto& c: children)
+                {
+                    if (res.size() > 1)
+                        res += type == AND ? " && " : " || ";
+                    res += c->explain();
+                }
+                return res + ")";
+            }
+        }
+    }
+};
+
+namespace {
+
+struct Parser
+{
+    enum Token { END, LPAREN, RPAREN, NOT, AND, OR, TAG };
+
+    const std::string& text;
+    size_t pos = 0;
+    /// Start of the current token
+    size_t start = 0;
+    Token token = END;
+    std::string value;
+
+    Parser(const std::string& text) : text(text) { next(); }
+
+    [[noreturn]] void error(const std::string& msg)
+    {
+        throw std::runtime_error("cannot parse tag expression \"" + text + "\": " + msg + " at position " + to_string(start));
+    }
+
+    static bool is_tag_char(char c)
+    {
+        return !isspace((unsigned char)c) && !strchr("()!&|", c);
+    }
+
+    void next()
+    {
+        while (pos < text.size() && isspace((unsigned char)text[pos]))
+            ++pos;
+        start = pos;
+        if (pos == text.size())
+        {
+            token = END;
+            return;
+        }
+        switch (text[pos])
+        {
+            case '(': ++pos; token = LPAREN; return;
+            case ')': ++pos; token = RPAREN; return;
+            case '!': ++pos; token = NOT; return;
+            case '&':
+            case '|':
+                token = text[pos] == '&' ? AND : OR;
+                // Accept both single and doubled operators
+                if (pos + 1 < text.size() && text[pos + 1] == text[pos])
+                    ++pos;
+                ++pos;
+                return;
+        }
+        while (pos < text.size() && is_tag_char(text[pos]))
+            ++pos;
+        value = text.substr(start, pos - start);
+        if (value == "and")
+            token = AND;
+        else if (value == "or")
+            token = OR;
+        else if (value == "not")
+            token = NOT;
+        else
+            token = TAG;
+    }
+
+    std::unique_ptr<Node> parse()
+    {
+        auto res = parse_or();
+        if (token != END)
+            error("unexpected '" + text.substr(start, pos - start) + "'");
+        return res;
+    }
+
+    std::unique_ptr<Node> parse_or()
+    {
+        auto first = parse_and();
+        if (token != OR)
+            return first;
+        std::unique_ptr<Node> res(new Node(Node::OR));
+        res->children.push_back(move(first));
+        while (token == OR)
+        {
+            next();
+            res->children.push_back(parse_and());
+        }
+        return res;
+    }
+
+    std::unique_ptr<Node> parse_and()
+    {
+        auto first = parse_not();
+        if (token != AND)
+            return first;
+        std::unique_ptr<Node> res(new Node(Node::AND));
+        res->children.push_back(move(first));
+        while (token == AND)
+        {
+            next();
+            res->children.push_back(parse_not());
+        }
+        return res;
+    }
+
+    std::unique_ptr<Node> parse_not()
+    {
+        switch (token)
+        {
+            case NOT:
+            {
+                next();
+                std::unique_ptr<Node> res(new Node(Node::NOT));
+                res->children.push_back(parse_not());
+                return res;
+            }
+            case LPAREN:
+            {
+                next();
+                auto res = parse_or();
+                if (token != RPAREN)
+                    error("expected ')'");
+                next();
+                return res;
+            }
+            case TAG:
+            {
+                bool wildcard = value.find_first_of("*?[") != std::string::npos;
+                std::unique_ptr<Node> res(new Node(wildcard ? Node::PATTERN : Node::TAG, value));
+                next();
+                return res;
+            }
+            case END:
+                error("unexpected end of expression");
+            default:
+                error("expected a tag");
+        }
+    }
+};
+
+struct Compiler
+{
+    const PostingIndex& index;
+
+    std::unique_ptr<Plan> postings(const std::string& label, const std::vector<uint32_t>& p)
+    {
+        std::unique_ptr<Plan> res(new Plan(Plan::POSTINGS, p.size()));
+        res->label = label;
+        res->postings = &p;
+        return res;
+    }
+
+    std::unique_ptr<Plan> compile(const Node& node)
+    {
+        size_t total = index.itemCount();
+        switch (node.type)
+        {
+            case Node::TAG:
+            {
+                const auto* p = index.find(node.name);
+                if (!p) return std::unique_ptr<Plan>(new Plan(Plan::NONE, 0));
+                return postings(node.name, *p);
+            }
+            case Node::PATTERN:
+            {
+                std::unique_ptr<Plan> res(new Plan(Plan::OR, 0));
+                index.match(node.name, [&](const std::string& tag, const std::vector<uint32_t>& p) {
+                    res->children.push_back(postings(tag, p));
+                    res->estimate += p.size();
+                });
+                return simplify_or(move(res));
+            }
+            case Node::NOT:
+            {
+                auto child = compile(*node.children[0]);
+                switch (child->type)
+                {
+                    case Plan::NONE: return std::unique_ptr<Plan>(new Plan(Plan::ALL, total));
+                    case Plan::ALL: return std::unique_ptr<Plan>(new Plan(Plan::NONE, 0));
+                    case Plan::NOT: return move(child->children[0]);
+                    default: break;
+                }
+                std::unique_ptr<Plan> res(new Plan(Plan::NOT, total - child->estimate));
+                res->children.push_back(move(child));
+                return res;
+            }
+            case Node::AND:
+            {
+                std::unique_ptr<Plan> res(new Plan(Plan::AND, total));
+                for (const auto& c: node.children)
+                {
+                    auto child = compile(*c);
+                    switch (child->type)
+                    {
+                        case Plan::NONE: return child;
+                        case Plan::ALL: break;
+                        case Plan::AND:
+                            for (auto& cc: child->children)
+                                res->children.push_back(move(cc));
+                            break;
+                        default:
+                            res->children.push_back(move(child));
+                            break;
+                    }
+                }
+                // Most selective terms first, negations last
+                stable_sort(res->children.begin(), res->children.end(), [](const std::unique_ptr<Plan>& a, const std::unique_ptr<Plan>& b) {
+                    if ((a->type == Plan::NOT) != (b->type == Plan::NOT))
+                        return b->type == Plan::NOT;
+                    return a->estimate < b->estimate;
+                });
+                for (const auto& c: res->children)
+                    res->estimate = min(res->estimate, c->estimate);
+                if (res->children.empty())
+                    return std::unique_ptr<Plan>(new Plan(Plan::ALL, total));
+                if (res->children.size() == 1)
+                    return move(res->children[0]);
+                return res;
+            }
+            case Node::OR:
+            {
+                std::unique_ptr<Plan> res(new Plan(Plan::OR, 0));
+                for (const auto& c: node.children)
+                {
+                    auto child = compile(*c);
+                    switch (child->type)
+                    {
+                        case Plan::ALL: return child;
+                        case Plan::NONE: break;
+                        case Plan::OR:
+                            res->estimate += child->estimate;
+                            for (auto& cc: child->children)
+                                res->children.push_back(move(cc));
+                            break;
+                        default:
+                            res->estimate += child->estimate;
+                            res->children.push_back(move(child));
+                            break;
+                    }
+                }
+                return simplify_or(move(res));
+            }
+        }
+        throw std::runtime_error("invalid tag expression node");
+    }
+
+    std::unique_ptr<Plan> simplify_or(std::unique_ptr<Plan> res)
+    {
+        if (res->children.empty())
+            return std::unique_ptr<Plan>(new Plan(Plan::NONE, 0));
+        if (res->children.size() == 1)
+            return move(res->children[0]);
+        res->estimate = min(res->estimate, index.itemCount());
+        return res;
+    }
+};
+
+struct Evaluator
+{
+    const PostingIndex& index;
+
+    Bitmap eval(const Plan& plan)
+    {
+        Bitmap res(index.itemCount());
+        switch (plan.type)
+        {
+            case Plan::NONE:
+                break;
+            case Plan::ALL:
+                res.fill();
+                break;
+            case Plan::POSTINGS:
+                res.set(*plan.postings);
+                break;
+            case Plan::NOT:
+                res = eval(*plan.children[0]);
+                res.flip();
+                break;
+            case Plan::OR:
+                for (const auto& c: plan.children)
+                {
+                    if (c->type == Plan::POSTINGS)
+                        res.set(*c->postings);
+                    else
+                        res |= eval(*c);
+                }
+                break;
+            case Plan::AND:
+            {
+                auto i = plan.children.begin();
+                if ((*i)->type == Plan::NOT)
+                    res.fill();
+                else
+                    res = eval(**i++);
+                for ( ; i != plan.children.end() && !res.none(); ++i)
+                {
+                    const Plan& c = **i;
+                    if (c.type == Plan::NOT)
+                        res.andNot(eval(*c.children[0]));
+                    else if (c.type == Plan::POSTINGS && res.count() * 16 < c.postings->size())
+                    {
+                        // Few candidates left: look them up in the postings
+                        // instead of expanding them into a bitmap
+                        const auto& p = *c.postings;
+                        res.filter([&](size_t id) { return binary_search(p.begin(), p.end(), id); });
+                    }
+                    else
+                        res &= eval(c);
+                }
+                break;
+            }
+        }
+        return res;
+    }
+};
+
+}
+
+}
+
+using namespace expression;
+
+/*
+ * Expression
+ */
+
+Expression::Expression(const std::string& text)
+    : text(text)
+{
+    Parser parser(this->text);
+    root = parser.parse();
+}
+
+Expression::Expression(Expression&&) = default;
+Expression::~Expression() {}
+Expression& Expression::operator=(Expression&&) = default;
+
+std::string Expression::format() const
+{
+    return root->format();
+}
+
+bool Expression::operator()(const std::set<std::string>& tags) const
+{
+    return root->match(tags);
+}
+
+ExpressionResult Expression::match(const PostingIndex& index) const
+{
+    return Query(*this, index).run();
+}
+
+
+/*
+ * Query
+ */
+
+Query::Query(const Expression& expr, const PostingIndex& index)
+    : index(index)
+{
+    Compiler compiler{index};
+    plan = compiler.compile(*expr.root);
+}
+
+Query::Query(Query&&) = default;
+Query::~Query() {}
+
+size_t Query::estimate() const
+{
+    return plan->estimate;
+}
+
+std::string Query::explain() const
+{
+    return plan->explain();
+}
+
+ExpressionResult Query::run() const
+{
+    Evaluator evaluator{index};
+    return ExpressionResult(index, evaluator.eval(*plan));
+}
+
+
+/*
+ * ExpressionResult
+ */
+
+std::set<std::string> ExpressionResult::items() const
+{
+    std::set<std::string> res;
+    for (const auto& i: *this)
+        res.insert(res.end(), i);
+    return res;
+}
+
+}
+}
+}
@@ -0,0 +1,169 @@
+#ifndef EPT_DEBTAGS_COLL_EXPRESSION_H
+#define EPT_DEBTAGS_COLL_EXPRESSION_H
+
+/** \file
+ * Boolean tag expressions
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/postings.h>
+#include <iterator>
+#include <memory>
+#include <set>
+#include <string>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+namespace expression {
+struct Node;
+struct Plan;
+}
+
+class ExpressionResult;
+
+/**
+ * Boolean expression over the tags of an item.
+ *
+ * The syntax is:
+ * \verbatim
+ *   expr := and ( ( "||" | "|" | "or" ) and )*
+ *   and  := not ( ( "&&" | "&" | "and" ) not )*
+ *   not  := ( "!" | "not" ) not | "(" expr ")" | tag
+ * \endverbatim
+ *
+ * A tag can contain shell wildcards, as in "implemented-in::*", and then
+ * matches if any tag matching the pattern is present.
+ *
+ * For example: "role::program && (interface::x11 || interface::commandline)
+ * && !use::gameplaying".
+ */
+class Expression
+{
+protected:
+    std::string text;
+    std::unique_ptr<expression::Node> root;
+
+    friend class Query;
+
+public:
+    /**
+     * Parse an expression.
+     *
+     * Throws std::runtime_error if the expression is not valid.
+     */
+    explicit Expression(const std::string& text);
+    Expression(Expression&&);
+    ~Expression();
+    Expression& operator=(Expression&&);
+
+    /// Return the expression as it was given to the constructor
+    const std::string& str() const { return text; }
+
+    /// Return the parsed expression in a normalised, fully parenthesised form
+    std::string format() const;
+
+    /// Check if a set of tags matches the expression
+    bool operator()(const std::set<std::string>& tags) const;
+
+    /// Return the items of \a index that match the expression
+    ExpressionResult match(const PostingIndex& index) const;
+};
+
+/**
+ * Expression compiled against a PostingIndex.
+ *
+ * Tags are resolved to their postings, wildcards are expanded, and the terms
+ * of each AND are sorted so that the most selective postings are evaluated
+ * first, and the evaluation can stop as soon as the partial result is empty.
+ * Negated terms are applied last, as differences.
+ */
+class Query
+{
+protected:
+    const PostingIndex& index;
+    std::unique_ptr<expression::Plan> plan;
+
+public:
+    Query(const Expression& expr, const PostingIndex& index);
+    Query(Query&&);
+    ~Query();
+
+    /// Return the estimated number of matching items
+    size_t estimate() const;
+
+    /// Return a description of the plan, in evaluation order
+    std::string explain() const;
+
+    /// Evaluate the query
+    ExpressionResult run() const;
+};
+
+/**
+ * Items matching a Query.
+ *
+ * The result is stored as a bitmap of item numbers: item names are only
+ * looked up while iterating, in the PostingIndex that must outlive the result.
+ */
+class ExpressionResult
+{
+protected:
+    const PostingIndex* index;
+    Bitmap bits;
+
+public:
+    ExpressionResult(const PostingIndex& index, Bitmap&& bits)
+        : index(&index), bits(std::move(bits)) {}
+
+    class const_iterator : public std::iterator<std::forward_iterator_tag, const std::string>
+    {
+        const ExpressionResult* res;
+        size_t pos;
+
+    public:
+        const_iterator(const ExpressionResult& res, size_t pos) : res(&res), pos(pos) {}
+
+        const std::string& operator*() const { return res->index->item(pos); }
+        const std::string* operator->() const { return &res->index->item(pos); }
+        const_iterator& operator++() { pos = res->bits.next(pos + 1); return *this; }
+        const_iterator operator++(int) { const_iterator res = *this; ++*this; return res; }
+        bool operator==(const const_iterator& o) const { return pos == o.pos; }
+        bool operator!=(const const_iterator& o) const { return pos != o.pos; }
+    };
+
+    const_iterator begin() const { return const_iterator(*this, bits.next(0)); }
+    const_iterator end() const { return const_iterator(*this, Bitmap::npos); }
+
+    /// Return the number of matching items
+    size_t size() const { return bits.count(); }
+
+    /// Return true if no item matched
+    bool empty() const { return bits.none(); }
+
+    /// Return the matching item numbers
+    const Bitmap& bitmap() const { return bits; }
+
+    /// Return the names of the matching items
+    std::set<std::string> items() const;
+};
+
+}
+}
+}
+#endif
@@ -0,0 +1,117 @@
+#include "ept/test.h"
+#include "fast.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+void check_same(const Fast& a, const Fast& b)
+{
+    wassert(actual(a.itemCount()) == b.itemCount());
+    wassert(actual(a.tagCount()) == b.tagCount());
+    for (const auto& i: b)
+        wassert_true(a.getTagsOfItem(i.first) == i.second);
+    for (auto t = b.tagBegin(); t != b.tagEnd(); ++t)
+        wassert_true(a.getItemsHavingTag(t->first) == t->second);
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("builder", []() {
+            // Pairs out of order and with duplicates
+            FastBuilder builder;
+            builder.add("b", "y");
+            builder.add("a", "y");
+            builder.add("b", "x");
+            builder.add("a", "z");
+            builder.add("b", "y");
+            builder.add("c", set<string>{ "z", "x" });
+            builder.add("d", set<string>());
+            wassert(actual(builder.size()) == 7u);
+
+            Fast built;
+            builder.build(built);
+            wassert(actual(builder.size()) == 0u);
+
+            Fast expected;
+            expected.insert("a", set<string>{ "y", "z" });
+            expected.insert("b", set<string>{ "x", "y" });
+            expected.insert("c", set<string>{ "x", "z" });
+            wassert(check_same(built, expected));
+            wassert_false(built.hasItem("d"));
+        });
+
+        add_method("builder_merge", []() {
+            // Building into a collection with contents merges the two
+            Fast built;
+            built.insert("a", set<string>{ "x" });
+            built.insert("e", set<string>{ "w" });
+
+            FastBuilder builder;
+            builder.add("a", "y");
+            builder.add("b", "x");
+            builder.build(built);
+
+            Fast expected;
+            expected.insert("a", set<string>{ "x", "y" });
+            expected.insert("b", set<string>{ "x" });
+            expected.insert("e", set<string>{ "w" });
+            wassert(check_same(built, expected));
+
+            // The builder can be reused after build()
+            builder.add("f", "v");
+            builder.build(built);
+            wassert_true(built.getItemsHavingTag("v") == set<string>{ "f" });
+        });
+
+        add_method("remove_tags_if", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x", "y" });
+            coll.insert("b", set<string>{ "x" });
+            coll.insert("c", set<string>{ "y", "z" });
+
+            coll.removeTagsIf([](const string& tag, const set<string>&) { return tag == "x"; });
+            Fast expected;
+            expected.insert("a", set<string>{ "y" });
+            expected.insert("c", set<string>{ "y", "z" });
+            wassert(check_same(coll, expected));
+
+            coll.removeTagsWithCardinalityLessThan(2);
+            expected.clear();
+            expected.insert("a", set<string>{ "y" });
+            expected.insert("c", set<string>{ "y" });
+            wassert(check_same(coll, expected));
+
+            coll.removeTagsWithCardinalityLessThan(3);
+            wassert_true(coll.empty());
+            wassert(actual(coll.tagCount()) == 0u);
+        });
+
+        add_method("remove_small_tags", []() {
+            // Compare with removing tags one by one on the test data
+            Fast coll;
+            load_test_tags(coll);
+
+            Fast expected = coll;
+            vector<string> small;
+            for (auto t = expected.tagBegin(); t != expected.tagEnd(); ++t)
+                if (t->second.size() < 20)
+                    small.push_back(t->first);
+            wassert(actual(small.size()) > 0u);
+            for (const auto& t: small)
+                expected.removeTag(t);
+
+            coll.removeTagsWithCardinalityLessThan(20);
+            wassert(check_same(coll, expected));
+        });
+    }
+} test("debtags_coll_fast");
+
+}
@@ -25,15 +25,29 @@
 
 #include <set>
 #include <map>
+#include <functional>
 #include <string>
 #include <vector>
+#include <unordered_map>
+#include <memory>
+#include <cstdint>
 
 namespace ept {
 namespace debtags {
 namespace coll {
 
+class View;
+class TagsetIndex;
+class PrefixIndex;
+class CardinalityIndex;
+
 /**
  * In-memory collection with both item->tags and tag->items mappings.
+ *
+ * The indices built from a collection, like TagsetIndex, SimilarityIndex or
+ * Navigator, copy what they need when they are constructed, and do not
+ * change if the collection is modified afterwards. Fast caches some of them,
+ * and drops the cached copies as soon as it is modified.
  */
 class Fast
 {
@@ -41,6 +55,28 @@ protected:
     std::map<std::string, std::set<std::string>> items;
     std::map<std::string, std::set<std::string>> tags;
 
+    /// Cached TagsetIndex, built on first use and dropped on changes
+    mutable std::shared_ptr<const TagsetIndex> tagset_index;
+
+    /// Cached PrefixIndex, built on first use and dropped on changes
+    mutable std::shared_ptr<const PrefixIndex> prefix_index;
+
+    /// Cached CardinalityIndex, built on first use and dropped on changes
+    mutable std::shared_ptr<const CardinalityIndex> cardinality_index;
+
+    /**
+     * Drop cached indices, after the collection has been changed.
+     *
+     * This uses atomic stores, like the cached accessors, so that the
+     * pointers are never read and written at the same time.
+     */
+    void invalidate()
+    {
+        std::atomic_store(&tagset_index, std::shared_ptr<const TagsetIndex>());
+        std::atomic_store(&prefix_index, std::shared_ptr<const PrefixIndex>());
+        std::atomic_store(&cardinality_index, std::shared_ptr<const CardinalityIndex>());
+    }
+
 public:
     typedef std::map<std::string, std::set<std::string>>::const_iterator const_iterator;
     typedef std::map<std::string, std::set<std::string>>::iterator iterator;
@@ -50,6 +86,9 @@ public:
 
     const_iterator begin() const { return items.begin(); }
     const_iterator end() const { return items.end(); }
+    // Changing the tag sets through non-const iterators would make items and
+    // tags disagree, and is not seen by the cached indices: use them only to
+    // read, or use the modifier methods
     iterator begin() { return items.begin(); }
     iterator end() { return items.end(); }
 
@@ -62,7 +101,7 @@ public:
     void insert(const std::set<std::string>& items, const std::string& tag);
     void insert(const std::set<std::string>& items, const std::set<std::string>& tags);
 
-    void clear() { items.clear(); tags.clear(); }
+    void clear() { items.clear(); tags.clear(); invalidate(); }
 
     std::set<std::string> getTagsOfItem(const std::string& item) const;
     std::set<std::string> getItemsHavingTag(const std::string& tag) const;
@@ -90,19 +129,111 @@ public:
     // tag2
     std::set<std::string> getTagsImplying(const std::string& tag) const;
 
-    // Return the items which have the exact tagset 'tags'
+    /**
+     * Return the items which have the exact tagset 'tags'.
+     *
+     * This uses tagsetIndex() if it has already been built, and otherwise
+     * intersects the items of each tag. Call tagsetIndex() first when
+     * making many queries.
+     */
     std::set<std::string> getItemsExactMatch(const std::set<std::string>& tags) const;
 
+    /**
+     * Return the index of the distinct tag sets of the collection.
+     *
+     * The index is built on first use and kept until the collection is
+     * changed. It is safe to call this from concurrent threads, as long as
+     * nothing changes the collection at the same time.
+     */
+    std::shared_ptr<const TagsetIndex> tagsetIndex() const;
+
+    /**
+     * Return the index of tag and facet names, to complete partial names.
+     *
+     * It is cached like tagsetIndex().
+     */
+    std::shared_ptr<const PrefixIndex> prefixIndex() const;
+
+    /**
+     * Return the tags sorted by cardinality, for top-k, threshold and
+     * percentile queries.
+     *
+     * It is cached like tagsetIndex().
+     */
+    std::shared_ptr<const CardinalityIndex> cardinalityIndex() const;
+
+    /**
+     * Return the tag with the most items, and its number of items in \a card.
+     *
+     * Ties are broken by tag name. This uses cardinalityIndex() if it has
+     * already been built, and otherwise scans the tags once.
+     */
     std::string findTagWithMaxCardinality(size_t& card) const;
 
     /**
      * Return the collection with only those items that have this tag, but with
-     * the given tag removed
+     * the given tag removed.
+     *
+     * This copies all the matching items: use View::getChildView to navigate
+     * the collection without copying it.
      */
     Fast getChildCollection(const std::string& tag) const;
 
     void removeTag(const std::string& tag);
+
+    /**
+     * Remove all the tags for which pred(tag, items) returns true, and the
+     * items left without tags.
+     *
+     * This is done in a single pass over the collection, instead of calling
+     * removeTag() for each tag.
+     */
+    void removeTagsIf(std::function<bool(const std::string& tag, const std::set<std::string>& items)> pred);
+
     void removeTagsWithCardinalityLessThan(size_t card);
+
+    friend class View;
+    friend class FastBuilder;
+};
+
+/**
+ * Accumulate (item, tag) pairs in any order, then add them all at once to a
+ * Fast collection.
+ *
+ * Item and tag names are stored only once, and pairs are kept as pairs of
+ * numbers. build() sorts the pairs once by item and once by tag, and fills
+ * each direction of the collection in a single ordered pass, instead of
+ * looking up and merging sets for every item as Fast::insert does.
+ */
+class FastBuilder
+{
+protected:
+    std::unordered_map<std::string, uint32_t> item_ids;
+    std::unordered_map<std::string, uint32_t> tag_ids;
+
+    /// Names by id, pointing to the keys of item_ids and tag_ids
+    std::vector<const std::string*> item_names;
+    std::vector<const std::string*> tag_names;
+
+    /// (item id << 32) | tag id of each pair, with possible duplicates
+    std::vector<uint64_t> pairs;
+
+public:
+    /// Add an (item, tag) pair
+    void add(const std::string& item, const std::string& tag);
+
+    /// Add an item with all its tags
+    void add(const std::string& item, const std::set<std::string>& tags);
+
+    /// Return the number of pairs added so far, counting duplicates
+    size_t size() const { return pairs.size(); }
+
+    /**
+     * Add all the pairs to \a out, which can already have contents.
+     *
+     * The builder is left empty.
+     */
+    void build(Fast& out);
 };
 
 }
@@ -0,0 +1,114 @@
+#include "ept/test.h"
+#include "navigator.h"
+#include "fast.h"
+#include <map>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+/// Check the navigator counts against counting the selected items in coll
+void check_counts(const Fast& coll, const Navigator& nav)
+{
+    map<string, unsigned> counts;
+    for (const auto& i: nav.items())
+        for (const auto& t: coll.getTagsOfItem(i))
+            ++counts[t];
+    for (const auto& c: counts)
+        wassert(actual(nav.count(c.first)) == c.second);
+    // Tags not in the selection are not ranked
+    for (const auto& c: nav.rankTags(1000))
+        wassert(actual(c.count) == counts[c.name]);
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("navigate", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "role::program", "interface::x11" });
+            coll.insert("b", set<string>{ "role::program", "interface::commandline" });
+            coll.insert("c", set<string>{ "role::program", "interface::x11", "use::gameplaying" });
+            coll.insert("d", set<string>{ "role::documentation" });
+
+            Navigator nav(coll);
+            wassert(actual(nav.size()) == 4u);
+            wassert(actual(nav.count("role::program")) == 3u);
+
+            // interface::x11 splits the items in half
+            auto tags = nav.rankTags(2);
+            wassert(actual(tags.size()) == 2u);
+            wassert(actual(tags[0].name) == "interface::x11");
+            wassert(actual(tags[0].count) == 2u);
+            wassert(actual(tags[0].entropy) == 1.0);
+            wassert(actual(tags[1].name) == "interface::commandline");
+
+            auto facets = nav.rankFacets(10);
+            wassert(actual(facets.size()) == 3u);
+            wassert(actual(facets[0].name) == "interface");
+            wassert(actual(facets[0].count) == 3u);
+            wassert(actual(facets[0].entropy) == 1.5);
+
+            nav.select("role::program");
+            wassert(actual(nav.size()) == 3u);
+            wassert(actual(nav.depth()) == 1u);
+            wassert(actual(nav.count("role::documentation")) == 0u);
+            // role no longer splits anything
+            for (const auto& f: nav.rankFacets(10))
+                wassert_true(f.name != "role");
+
+            nav.reject("interface::x11");
+            wassert(actual(nav.size()) == 1u);
+            wassert(actual(nav.items()[0]) == "b");
+            wassert(actual(nav.rankTags(10).size()) == 0u);
+
+            wassert_true(nav.back());
+            wassert(actual(nav.size()) == 3u);
+            wassert(actual(nav.count("interface::x11")) == 2u);
+            wassert_true(nav.back());
+            wassert(actual(nav.size()) == 4u);
+            wassert(actual(nav.count("role::documentation")) == 1u);
+            wassert_false(nav.back());
+
+            nav.select("missing");
+            wassert(actual(nav.size()) == 0u);
+            wassert(actual(nav.count("role::program")) == 0u);
+            nav.back();
+            nav.reject("missing");
+            wassert(actual(nav.size()) == 4u);
+        });
+
+        add_method("compare", []() {
+            // Follow the best split a few times on the test data, checking
+            // the counts at each step
+            Fast coll;
+            load_test_tags(coll);
+
+            Navigator nav(coll);
+            wassert(actual(nav.size()) == coll.itemCount());
+            for (unsigned i = 0; i < 4; ++i)
+            {
+                auto best = nav.rankTags(1);
+                if (best.empty()) break;
+                size_t before = nav.size();
+                if (i % 2)
+                    nav.reject(best[0].name);
+                else
+                    nav.select(best[0].name);
+                wassert(actual(nav.size()) < before);
+                check_counts(coll, nav);
+            }
+            while (nav.back())
+                check_counts(coll, nav);
+            wassert(actual(nav.size()) == coll.itemCount());
+        });
+    }
+} test("debtags_coll_navigator");
+
+}
@@ -0,0 +1,270 @@
+/*
+ * Guided narrowing down of a tag collection
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/navigator.h>
+#include <ept/debtags/coll/fast.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+namespace {
+
+const uint32_t no_facet = (uint32_t)-1;
+
+/// Return x * log2(x), with 0 * log2(0) = 0
+double xlogx(double x)
+{
+    return x > 0 ? x * log2(x) : 0;
+}
+
+}
+
+Navigator::Navigator(const Fast& coll)
+{
+    // Number tags in sorted order, so that the tags of a facet are
+    // consecutive in each item
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+    {
+        uint32_t id = tag_names.size();
+        tag_ids.insert(make_pair(t->first, id));
+        tag_names.push_back(t->first);
+        tag_counts.push_back(t->second.size());
+        active_pos.push_back(active.size());
+        active.push_back(id);
+
+        size_t pos = t->first.find("::");
+        if (pos == string::npos)
+            tag_facet.push_back(no_facet);
+        else
+        {
+            auto res = facet_ids.insert(make_pair(t->first.substr(0, pos), (uint32_t)facet_names.size()));
+            if (res.second)
+                facet_names.push_back(res.first->first);
+            tag_facet.push_back(res.first->second);
+        }
+    }
+    facet_counts.resize(facet_names.size());
+
+    item_names.reserve(coll.itemCount());
+    item_offsets.reserve(coll.itemCount() + 1);
+    item_offsets.push_back(0);
+    selection.reserve(coll.itemCount());
+    for (const auto& i: coll)
+    {
+        uint32_t prev_facet = no_facet;
+        for (const auto& t: i.second)
+        {
+            uint32_t id = tag_ids.find(t)->second;
+            item_tags.push_back(id);
+            uint32_t f = tag_facet[id];
+            if (f != no_facet && f != prev_facet)
+                ++facet_counts[f];
+            prev_facet = f;
+        }
+        item_offsets.push_back(item_tags.size());
+        selection.push_back(item_names.size());
+        item_names.push_back(i.first);
+    }
+}
+
+bool Navigator::hasTag(uint32_t item, uint32_t tag) const
+{
+    return binary_search(item_tags.begin() + item_offsets[item], item_tags.begin() + item_offsets[item + 1], tag);
+}
+
+void Navigator::count(uint32_t item, int delta)
+{
+    uint32_t prev_facet = no_facet;
+    for (uint32_t p = item_offsets[item]; p < item_offsets[item + 1]; ++p)
+    {
+        uint32_t t = item_tags[p];
+        if (delta > 0 && tag_counts[t] == 0)
+        {
+            active_pos[t] = active.size();
+            active.push_back(t);
+        }
+        tag_counts[t] += delta;
+        if (tag_counts[t] == 0)
+        {
+            // Move the last active tag into the place of t
+            uint32_t last = active.back();
+            active[active_pos[t]] = last;
+            active_pos[last] = active_pos[t];
+            active.pop_back();
+        }
+
+        uint32_t f = tag_facet[t];
+        if (f != no_facet && f != prev_facet)
+            facet_counts[f] += delta;
+        prev_facet = f;
+    }
+}
+
+void Navigator::recount()
+{
+    for (const auto& t: active)
+        tag_counts[t] = 0;
+    active.clear();
+    fill(facet_counts.begin(), facet_counts.end(), 0);
+    for (const auto& i: selection)
+        count(i, 1);
+}
+
+void Navigator::narrow(const std::string& tag, bool has)
+{
+    auto t = tag_ids.find(tag);
+    vector<uint32_t> kept;
+    vector<uint32_t> removed;
+    for (const auto& i: selection)
+    {
+        if ((t != tag_ids.end() && hasTag(i, t->second)) == has)
+            kept.push_back(i);
+        else
+            removed.push_back(i);
+    }
+
+    steps.push_back(Step{ tag, has, move(selection) });
+    selection = move(kept);
+
+    // Update the counts with whichever is fewer, the items that left or the
+    // items that stayed
+    if (removed.size() <= selection.size())
+        for (const auto& i: removed)
+            count(i, -1);
+    else
+        recount();
+}
+
+bool Navigator::back()
+{
+    if (steps.empty())
+        return false;
+
+    vector<uint32_t> previous = move(steps.back().selection);
+    steps.pop_back();
+
+    // Count again the items that the step had removed
+    vector<uint32_t> added;
+    set_difference(previous.begin(), previous.end(), selection.begin(), selection.end(), back_inserter(added));
+    for (const auto& i: added)
+        count(i, 1);
+    selection = move(previous);
+    return true;
+}
+
+std::vector<std::string> Navigator::items() const
+{
+    std::vector<std::string> res;
+    res.reserve(selection.size());
+    for (const auto& i: selection)
+        res.push_back(item_names[i]);
+    return res;
+}
+
+unsigned Navigator::count(const std::string& tag) const
+{
+    auto i = tag_ids.find(tag);
+    if (i == tag_ids.end())
+        return 0;
+    return tag_counts[i->second];
+}
+
+std::vector<Navigator::Choice> Navigator::rankTags(unsigned k) const
+{
+    unsigned n = selection.size();
+    vector<uint32_t> candidates;
+    for (const auto& t: active)
+        if (tag_counts[t] < n)
+            candidates.push_back(t);
+
+    // The entropy of a split grows as it gets closer to half and half:
+    // compare the distance from half with integers, to sort ties exactly
+    auto better = [&](uint32_t a, uint32_t b) {
+        long da = labs(2l * tag_counts[a] - n);
+        long db = labs(2l * tag_counts[b] - n);
+        if (da != db) return da < db;
+        return a < b;
+    };
+    if (candidates.size() > k)
+    {
+        partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), better);
+        candidates.resize(k);
+    }
+    else
+        sort(candidates.begin(), candidates.end(), better);
+
+    std::vector<Choice> res;
+    res.reserve(candidates.size());
+    for (const auto& t: candidates)
+    {
+        double p = (double)tag_counts[t] / n;
+        res.push_back(Choice{ tag_names[t], tag_counts[t], -xlogx(p) - xlogx(1 - p) });
+    }
+    return res;
+}
+
+std::vector<Navigator::Choice> Navigator::rankFacets(unsigned k) const
+{
+    // Sum the counts of the tags in each facet, and how many of them are
+    // present
+    vector<double> sums(facet_names.size(), 0);
+    vector<double> xlogxs(facet_names.size(), 0);
+    vector<unsigned> present(facet_names.size(), 0);
+    for (const auto& t: active)
+    {
+        uint32_t f = tag_facet[t];
+        if (f == no_facet) continue;
+        sums[f] += tag_counts[t];
+        xlogxs[f] += xlogx(tag_counts[t]);
+        ++present[f];
+    }
+
+    std::vector<Choice> res;
+    for (uint32_t f = 0; f < facet_names.size(); ++f)
+    {
+        if (!present[f]) continue;
+        unsigned none = selection.size() - facet_counts[f];
+        // A facet with a single category does not split anything
+        if (present[f] + (none ? 1 : 0) < 2) continue;
+        double total = sums[f] + none;
+        double entropy = log2(total) - (xlogxs[f] + xlogx(none)) / total;
+        res.push_back(Choice{ facet_names[f], facet_counts[f], entropy });
+    }
+
+    auto better = [](const Choice& a, const Choice& b) {
+        if (a.entropy != b.entropy) return a.entropy > b.entropy;
+        return a.name < b.name;
+    };
+    if (res.size() > k)
+    {
+        partial_sort(res.begin(), res.begin() + k, res.end(), better);
+        res.resize(k);
+    }
+    else
+        sort(res.begin(), res.end(), better);
+    return res;
+}
+
+}
+}
+}
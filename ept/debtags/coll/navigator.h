@@ -0,0 +1,143 @@
+#ifndef EPT_DEBTAGS_COLL_NAVIGATOR_H
+#define EPT_DEBTAGS_COLL_NAVIGATOR_H
+
+/** \file
+ * Guided narrowing down of a tag collection
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/**
+ * Narrow down the items of a collection one tag at a time, suggesting at
+ * each step the tags and facets that best split the remaining items.
+ *
+ * Tags are ranked by the entropy of the split between the items that have
+ * them and the items that do not: the closer to half and half, the more a
+ * yes/no answer narrows the choice. Facets are ranked by the entropy of the
+ * distribution of the remaining items across their tags (counting an item
+ * once per tag), plus the items with no tag in the facet.
+ *
+ * The navigator keeps the count of each tag in the current selection, and
+ * updates it at each step with only the items that left the selection, or
+ * recounts the items that stayed if they are fewer. The cost of a step
+ * depends on the size of the selection, not of the whole collection, and
+ * ranking only looks at the tags present in the selection.
+ */
+class Navigator
+{
+public:
+    struct Choice
+    {
+        /// Tag or facet name
+        std::string name;
+        /// Number of items in the selection with the tag, or with any tag in the facet
+        unsigned count;
+        /// Entropy of the split, in bits
+        double entropy;
+    };
+
+protected:
+    std::vector<std::string> item_names;
+    std::vector<std::string> tag_names;
+    std::unordered_map<std::string, uint32_t> tag_ids;
+    std::vector<std::string> facet_names;
+    std::unordered_map<std::string, uint32_t> facet_ids;
+    /// Facet of each tag, or -1 for tags with no facet
+    std::vector<uint32_t> tag_facet;
+
+    /// Sorted tags of item i are item_tags[item_offsets[i]] to item_tags[item_offsets[i + 1]]
+    std::vector<uint32_t> item_offsets;
+    std::vector<uint32_t> item_tags;
+
+    /// Items in the current selection, sorted
+    std::vector<uint32_t> selection;
+
+    /// Number of items in the selection with each tag
+    std::vector<unsigned> tag_counts;
+    /// Tags with a nonzero count
+    std::vector<uint32_t> active;
+    /// Position of each tag in active
+    std::vector<uint32_t> active_pos;
+    /// Number of items in the selection with any tag of each facet
+    std::vector<unsigned> facet_counts;
+
+    struct Step
+    {
+        std::string tag;
+        bool has;
+        std::vector<uint32_t> selection;
+    };
+    /// Steps taken, with the selection before each
+    std::vector<Step> steps;
+
+    bool hasTag(uint32_t item, uint32_t tag) const;
+    void count(uint32_t item, int delta);
+    void recount();
+    void narrow(const std::string& tag, bool has);
+
+public:
+    /// Start navigating \a coll, with all its items selected
+    explicit Navigator(const Fast& coll);
+
+    /// Return the number of selected items
+    size_t size() const { return selection.size(); }
+
+    /// Return the names of the selected items, sorted
+    std::vector<std::string> items() const;
+
+    /// Return the number of selected items with \a tag
+    unsigned count(const std::string& tag) const;
+
+    /// Keep only the selected items that have \a tag
+    void select(const std::string& tag) { narrow(tag, true); }
+
+    /// Keep only the selected items that do not have \a tag
+    void reject(const std::string& tag) { narrow(tag, false); }
+
+    /// Undo the last select() or reject(); return false if there is none
+    bool back();
+
+    /// Return the number of select() and reject() steps taken
+    size_t depth() const { return steps.size(); }
+
+    /**
+     * Return up to \a k tags that split the selection, best split first.
+     *
+     * Tags that all or none of the selected items have are not returned.
+     * Ties are sorted by name.
+     */
+    std::vector<Choice> rankTags(unsigned k) const;
+
+    /// Return up to \a k facets that split the selection, best split first
+    std::vector<Choice> rankFacets(unsigned k) const;
+};
+
+}
+}
+}
+#endif
@@ -0,0 +1,162 @@
+/*
+ * Integer postings and bitmaps for tag collections
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/postings.h>
+#include <ept/debtags/coll/fast.h>
+#include <algorithm>
+#include <fnmatch.h>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+/*
+ * Bitmap
+ */
+
+const size_t Bitmap::npos;
+
+void Bitmap::trim()
+{
+    if (bits % 64)
+        words.back() &= ((uint64_t)1 << (bits % 64)) - 1;
+}
+
+void Bitmap::fill()
+{
+    std::fill(words.begin(), words.end(), ~(uint64_t)0);
+    trim();
+}
+
+size_t Bitmap::count() const
+{
+    size_t res = 0;
+    for (const auto& w: words)
+        res += __builtin_popcountll(w);
+    return res;
+}
+
+bool Bitmap::none() const
+{
+    for (const auto& w: words)
+        if (w) return false;
+    return true;
+}
+
+size_t Bitmap::next(size_t pos) const
+{
+    if (pos >= bits)
+        return npos;
+    size_t w = pos / 64;
+    uint64_t cur = words[w] & (~(uint64_t)0 << (pos % 64));
+    while (true)
+    {
+        if (cur)
+            return w * 64 + __builtin_ctzll(cur);
+        if (++w == words.size())
+            return npos;
+        cur = words[w];
+    }
+}
+
+void Bitmap::set(const std::vector<uint32_t>& postings)
+{
+    for (const auto& p: postings)
+        set(p);
+}
+
+void Bitmap::filter(std::function<bool(size_t)> pred)
+{
+    for (size_t i = next(0); i != npos; i = next(i + 1))
+        if (!pred(i))
+            reset(i);
+}
+
+Bitmap& Bitmap::operator&=(const Bitmap& o)
+{
+    for (size_t i = 0; i < words.size(); ++i)
+        words[i] &= o.words[i];
+    return *this;
+}
+
+Bitmap& Bitmap::operator|=(const Bitmap& o)
+{
+    for (size_t i = 0; i < words.size(); ++i)
+        words[i] |= o.words[i];
+    return *this;
+}
+
+Bitmap& Bitmap::andNot(const Bitmap& o)
+{
+    for (size_t i = 0; i < words.size(); ++i)
+        words[i] &= ~o.words[i];
+    return *this;
+}
+
+void Bitmap::flip()
+{
+    for (auto& w: words)
+        w = ~w;
+    trim();
+}
+
+
+/*
+ * PostingIndex
+ */
+
+PostingIndex::PostingIndex(const Fast& coll)
+{
+    items.reserve(coll.itemCount());
+    for (const auto& i: coll)
+    {
+        uint32_t id = items.size();
+        items.push_back(i.first);
+        // Items are visited in order, so each posting list comes out sorted
+        for (const auto& t: i.second)
+            postings[t].push_back(id);
+    }
+}
+
+const std::vector<uint32_t>* PostingIndex::find(const std::string& tag) const
+{
+    auto i = postings.find(tag);
+    if (i == postings.end())
+        return nullptr;
+    return &i->second;
+}
+
+void PostingIndex::match(const std::string& pattern, std::function<void(const std::string&, const std::vector<uint32_t>&)> fun) const
+{
+    // Only look at the tags that start with the part of the pattern before
+    // the first wildcard character, such as the facet in "facet::*"
+    string prefix = pattern.substr(0, pattern.find_first_of("*?[\\"));
+    for (auto i = postings.lower_bound(prefix); i != postings.end(); ++i)
+    {
+        if (i->first.compare(0, prefix.size(), prefix) != 0)
+            break;
+        if (fnmatch(pattern.c_str(), i->first.c_str(), 0) == 0)
+            fun(i->first, i->second);
+    }
+}
+
+}
+}
+}
@@ -0,0 +1,136 @@
+#ifndef EPT_DEBTAGS_COLL_POSTINGS_H
+#define EPT_DEBTAGS_COLL_POSTINGS_H
+
+/** \file
+ * Integer postings and bitmaps for tag collections
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/**
+ * Fixed size set of small integers, stored one bit per integer.
+ */
+class Bitmap
+{
+protected:
+    size_t bits;
+    std::vector<uint64_t> words;
+
+    /// Clear the unused bits of the last word
+    void trim();
+
+public:
+    /// Value returned by next() when there are no more bits set
+    static const size_t npos = (size_t)-1;
+
+    /// Create a bitmap for the integers 0 to \a bits - 1, all unset
+    explicit Bitmap(size_t bits = 0) : bits(bits), words((bits + 63) / 64) {}
+
+    /// Return the number of integers the bitmap can hold
+    size_t size() const { return bits; }
+
+    void set(size_t pos) { words[pos / 64] |= (uint64_t)1 << (pos % 64); }
+    void reset(size_t pos) { words[pos / 64] &= ~((uint64_t)1 << (pos % 64)); }
+    bool test(size_t pos) const { return words[pos / 64] & ((uint64_t)1 << (pos % 64)); }
+
+    /// Set all the bits
+    void fill();
+
+    /// Return the number of bits set
+    size_t count() const;
+
+    /// Return true if no bits are set
+    bool none() const;
+
+    /// Return the first bit set at or after \a pos, or npos
+    size_t next(size_t pos) const;
+
+    /// Set all the integers in a sorted posting list
+    void set(const std::vector<uint32_t>& postings);
+
+    /// Keep only the bits for which pred(pos) returns true
+    void filter(std::function<bool(size_t)> pred);
+
+    Bitmap& operator&=(const Bitmap& o);
+    Bitmap& operator|=(const Bitmap& o);
+
+    /// Unset all the bits set in \a o
+    Bitmap& andNot(const Bitmap& o);
+
+    /// Invert all the bits
+    void flip();
+};
+
+/**
+ * Read-only index of a tag collection with items numbered by integers.
+ *
+ * Items are numbered from 0 in sorted order, and each tag has a sorted list
+ * of the numbers of its items (its postings). This is the data that
+ * Expression evaluates queries on.
+ */
+class PostingIndex
+{
+protected:
+    /// Item names, sorted
+    std::vector<std::string> items;
+
+    /// Postings of each tag
+    std::map<std::string, std::vector<uint32_t>> postings;
+
+public:
+    /// Index the contents of \a coll
+    explicit PostingIndex(const Fast& coll);
+
+    /// Return the number of items
+    size_t itemCount() const { return items.size(); }
+
+    /// Return the number of tags
+    size_t tagCount() const { return postings.size(); }
+
+    /// Return the name of an item given its number
+    const std::string& item(uint32_t id) const { return items[id]; }
+
+    /**
+     * Return the sorted item numbers of a tag, or nullptr if no item has the
+     * tag
+     */
+    const std::vector<uint32_t>* find(const std::string& tag) const;
+
+    /**
+     * Call fun(tag, postings) for all the tags that match a shell wildcard
+     * pattern, such as "implemented-in::*", in tag order
+     */
+    void match(const std::string& pattern, std::function<void(const std::string&, const std::vector<uint32_t>&)> fun) const;
+};
+
+}
+}
+}
+#endif
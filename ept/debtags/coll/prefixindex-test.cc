@@ -0,0 +1,113 @@
+#include "ept/test.h"
+#include "prefixindex.h"
+#include "fast.h"
+#include <map>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+vector<string> names(const PrefixIndex::Range& r)
+{
+    vector<string> res;
+    for (const auto& e: r)
+        res.push_back(string(e.name, e.size));
+    return res;
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("complete", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "works-with::image", "works-with::image:raster", "works-with-format::png" });
+            coll.insert("b", set<string>{ "works-with::text", "works-with::image" });
+            coll.insert("c", set<string>{ "made-of::html", "legacy" });
+
+            PrefixIndex index(coll);
+            wassert(actual(index.tags().size()) == 6u);
+            wassert(actual(index.facets().size()) == 3u);
+
+            auto tags = names(index.tags("works-with::"));
+            wassert(actual(tags.size()) == 3u);
+            wassert(actual(tags[0]) == "works-with::image");
+            wassert(actual(tags[1]) == "works-with::image:raster");
+            wassert(actual(tags[2]) == "works-with::text");
+            wassert(actual(index.tags("works-with::im").size()) == 2u);
+            wassert(actual(index.tags("works-with").size()) == 4u);
+            wassert(actual(index.tags("works-with::image:raster:").size()) == 0u);
+            wassert(actual(index.tags("z").size()) == 0u);
+            wassert(actual(index.tags("").size()) == 6u);
+
+            wassert(actual(index.tags("works-with::image").begin()->cardinality) == 2u);
+
+            auto facets = names(index.facets("works"));
+            wassert(actual(facets.size()) == 2u);
+            wassert(actual(facets[0]) == "works-with");
+            wassert(actual(facets[1]) == "works-with-format");
+
+            // Facet cardinality counts items, not tags
+            wassert(actual(index.facet("works-with")->cardinality) == 2u);
+            wassert(actual(index.facet("made-of")->cardinality) == 1u);
+            wassert_true(index.facet("works") == nullptr);
+            wassert_true(index.facet("legacy") == nullptr);
+
+            wassert(actual(index.tag("works-with::image:raster")->cardinality) == 1u);
+            wassert_true(index.tag("works-with::imag") == nullptr);
+            wassert_true(index.tag("legacy") != nullptr);
+        });
+
+        add_method("cache", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x::y" });
+            auto index = coll.prefixIndex();
+            wassert_true(coll.prefixIndex() == index);
+            coll.insert("b", set<string>{ "x::z" });
+            wassert_true(coll.prefixIndex() != index);
+            wassert(actual(coll.prefixIndex()->tags("x::").size()) == 2u);
+            wassert(actual(index->tags("x::").size()) == 1u);
+        });
+
+        add_method("compare", []() {
+            // Compare with scanning all the tags of the test data
+            Fast coll;
+            load_test_tags(coll);
+
+            auto index = coll.prefixIndex();
+            map<string, unsigned> facets;
+            for (const auto& i: coll)
+            {
+                set<string> seen;
+                for (const auto& t: i.second)
+                {
+                    size_t pos = t.find("::");
+                    if (pos != string::npos)
+                        seen.insert(t.substr(0, pos));
+                }
+                for (const auto& f: seen)
+                    ++facets[f];
+            }
+            wassert(actual(index->facets().size()) == facets.size());
+            for (const auto& f: facets)
+            {
+                wassert(actual(index->facet(f.first)->cardinality) == f.second);
+
+                size_t count = 0;
+                for (const auto& t: coll.getAllTags())
+                    if (t.compare(0, f.first.size() + 2, f.first + "::") == 0)
+                        ++count;
+                wassert(actual(index->tags(f.first + "::").size()) == count);
+                for (const auto& e: index->tags(f.first + "::"))
+                    wassert(actual(e.cardinality) == coll.getItemsHavingTag(e.name).size());
+            }
+        });
+    }
+} test("debtags_coll_prefixindex");
+
+}
@@ -0,0 +1,123 @@
+/*
+ * Prefix index of the tag and facet names of a tag collection
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/prefixindex.h>
+#include <ept/debtags/coll/fast.h>
+#include <algorithm>
+#include <map>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+namespace {
+
+/// Compare the first \a size characters of an entry name with \a prefix
+int compare_prefix(const PrefixIndex::Entry& e, const char* prefix, size_t size)
+{
+    int res = memcmp(e.name, prefix, min(e.size, size));
+    if (res != 0 || e.size >= size)
+        return res;
+    // The entry is shorter than the prefix, and the same up to its length
+    return -1;
+}
+
+}
+
+PrefixIndex::PrefixIndex(const Fast& coll)
+{
+    // Facets and their number of items. Tags in an item are sorted, so the
+    // tags of a facet are consecutive
+    map<string, unsigned> facet_cards;
+    for (const auto& i: coll)
+    {
+        string last;
+        for (const auto& t: i.second)
+        {
+            size_t pos = t.find("::");
+            if (pos == string::npos)
+                continue;
+            if (last.size() == pos && t.compare(0, pos, last) == 0)
+                continue;
+            last = t.substr(0, pos);
+            ++facet_cards[last];
+        }
+    }
+
+    // Lay out all the names first, since entries point into the buffer
+    size_t size = 0;
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+        size += t->first.size() + 1;
+    for (const auto& f: facet_cards)
+        size += f.first.size() + 1;
+    names.reserve(size);
+
+    vector<pair<size_t, unsigned>> tag_offsets;
+    tag_offsets.reserve(coll.tagCount());
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+    {
+        tag_offsets.push_back(make_pair(names.size(), (unsigned)t->second.size()));
+        names.insert(names.end(), t->first.c_str(), t->first.c_str() + t->first.size() + 1);
+    }
+    vector<pair<size_t, unsigned>> facet_offsets;
+    facet_offsets.reserve(facet_cards.size());
+    for (const auto& f: facet_cards)
+    {
+        facet_offsets.push_back(make_pair(names.size(), f.second));
+        names.insert(names.end(), f.first.c_str(), f.first.c_str() + f.first.size() + 1);
+    }
+
+    tag_entries.reserve(tag_offsets.size());
+    for (const auto& o: tag_offsets)
+    {
+        const char* name = names.data() + o.first;
+        tag_entries.push_back(Entry{ name, strlen(name), o.second });
+    }
+    facet_entries.reserve(facet_offsets.size());
+    for (const auto& o: facet_offsets)
+    {
+        const char* name = names.data() + o.first;
+        facet_entries.push_back(Entry{ name, strlen(name), o.second });
+    }
+}
+
+PrefixIndex::Range PrefixIndex::prefixRange(const std::vector<Entry>& entries, const char* prefix, size_t size)
+{
+    const Entry* begin = entries.data();
+    const Entry* end = begin + entries.size();
+    // Entries starting with the prefix are the ones comparing equal to it
+    // when truncated to its length
+    const Entry* first = partition_point(begin, end, [&](const Entry& e) { return compare_prefix(e, prefix, size) < 0; });
+    const Entry* last = partition_point(first, end, [&](const Entry& e) { return compare_prefix(e, prefix, size) == 0; });
+    return Range(first, last);
+}
+
+const PrefixIndex::Entry* PrefixIndex::find(const std::vector<Entry>& entries, const char* name, size_t size)
+{
+    Range r = prefixRange(entries, name, size);
+    // The exact match, if present, is the shortest and sorts first
+    if (r.empty() || r.begin()->size != size)
+        return nullptr;
+    return r.begin();
+}
+
+}
+}
+}
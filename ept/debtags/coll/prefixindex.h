@@ -0,0 +1,120 @@
+#ifndef EPT_DEBTAGS_COLL_PREFIXINDEX_H
+#define EPT_DEBTAGS_COLL_PREFIXINDEX_H
+
+/** \file
+ * Prefix index of the tag and facet names of a tag collection
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/**
+ * Sorted arrays of the tag and facet names of a collection, with the number
+ * of items of each, for completing partially typed names.
+ *
+ * All names are stored in a single buffer, and lookups return ranges into the
+ * arrays, so completing a prefix does not allocate memory.
+ *
+ * The facet of a tag is the part of its name before "::": tags without "::"
+ * are not part of any facet. The cardinality of a facet is the number of items
+ * with at least one tag in the facet.
+ */
+class PrefixIndex
+{
+public:
+    struct Entry
+    {
+        /// Name, 0-terminated
+        const char* name;
+        /// Length of name
+        size_t size;
+        /// Number of items
+        unsigned cardinality;
+    };
+
+    /// Sequence of consecutive entries
+    class Range
+    {
+        const Entry* first;
+        const Entry* last;
+
+    public:
+        Range(const Entry* first, const Entry* last) : first(first), last(last) {}
+
+        const Entry* begin() const { return first; }
+        const Entry* end() const { return last; }
+        size_t size() const { return last - first; }
+        bool empty() const { return first == last; }
+    };
+
+protected:
+    /// All the names, each followed by a 0
+    std::vector<char> names;
+    /// Tags, sorted by name
+    std::vector<Entry> tag_entries;
+    /// Facets, sorted by name
+    std::vector<Entry> facet_entries;
+
+    static Range prefixRange(const std::vector<Entry>& entries, const char* prefix, size_t size);
+    static const Entry* find(const std::vector<Entry>& entries, const char* name, size_t size);
+
+public:
+    /// Index the tags of \a coll
+    explicit PrefixIndex(const Fast& coll);
+    PrefixIndex(const PrefixIndex&) = delete;
+    PrefixIndex& operator=(const PrefixIndex&) = delete;
+
+    /// Return all the tags, sorted by name
+    Range tags() const { return Range(tag_entries.data(), tag_entries.data() + tag_entries.size()); }
+
+    /// Return all the facets, sorted by name
+    Range facets() const { return Range(facet_entries.data(), facet_entries.data() + facet_entries.size()); }
+
+    /**
+     * Return the tags whose name starts with \a prefix, sorted by name.
+     *
+     * tags("works-with::") returns the tags of the facet works-with.
+     */
+    Range tags(const char* prefix, size_t size) const { return prefixRange(tag_entries, prefix, size); }
+    Range tags(const char* prefix) const { return tags(prefix, strlen(prefix)); }
+    Range tags(const std::string& prefix) const { return tags(prefix.data(), prefix.size()); }
+
+    /// Return the facets whose name starts with \a prefix, sorted by name
+    Range facets(const char* prefix, size_t size) const { return prefixRange(facet_entries, prefix, size); }
+    Range facets(const char* prefix) const { return facets(prefix, strlen(prefix)); }
+    Range facets(const std::string& prefix) const { return facets(prefix.data(), prefix.size()); }
+
+    /// Return the tag with the given name, or nullptr if it is not present
+    const Entry* tag(const std::string& name) const { return find(tag_entries, name.data(), name.size()); }
+
+    /// Return the facet with the given name, or nullptr if it is not present
+    const Entry* facet(const std::string& name) const { return find(facet_entries, name.data(), name.size()); }
+};
+
+}
+}
+}
+#endif
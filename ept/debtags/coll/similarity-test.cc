@@ -0,0 +1,105 @@
+#include "ept/test.h"
+#include "similarity.h"
+#include "fast.h"
+#include <algorithm>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+/// Find the top k by comparing with all items
+vector<pair<string, double>> brute_force(const Fast& coll, const set<string>& tags, unsigned k, const string& skip)
+{
+    vector<pair<string, double>> res;
+    for (const auto& i: coll)
+    {
+        if (i.first == skip) continue;
+        size_t common = 0;
+        for (const auto& t: i.second)
+            if (tags.find(t) != tags.end())
+                ++common;
+        if (!common) continue;
+        res.push_back(make_pair(i.first, (double)common / (tags.size() + i.second.size() - common)));
+    }
+    stable_sort(res.begin(), res.end(), [](const pair<string, double>& a, const pair<string, double>& b) {
+        return a.second > b.second;
+    });
+    if (res.size() > k)
+        res.resize(k);
+    return res;
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("similar", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x", "y", "z" });
+            coll.insert("b", set<string>{ "x", "y" });
+            coll.insert("c", set<string>{ "x", "y", "z", "w" });
+            coll.insert("d", set<string>{ "w" });
+            coll.insert("e", set<string>{ "x", "y", "z" });
+
+            SimilarityIndex index(coll, 2);
+            wassert(actual(index.itemCount()) == 5u);
+
+            auto res = index.similar("a", 10);
+            wassert(actual(res.size()) == 3u);
+            wassert(actual(res[0].item) == "e");
+            wassert(actual(res[0].similarity) == 1.0);
+            wassert(actual(res[0].common) == 3u);
+            wassert(actual(res[1].item) == "c");
+            wassert(actual(res[1].similarity) == 0.75);
+            wassert(actual(res[2].item) == "b");
+
+            res = index.similar("a", 1);
+            wassert(actual(res.size()) == 1u);
+            wassert(actual(res[0].item) == "e");
+
+            wassert(actual(index.similar("missing", 3).size()) == 0u);
+            wassert(actual(index.similar("a", 0).size()) == 0u);
+
+            res = index.nearest(set<string>{ "w", "unknown" }, 2);
+            wassert(actual(res.size()) == 2u);
+            wassert(actual(res[0].item) == "d");
+            wassert(actual(res[0].similarity) == 0.5);
+            wassert(actual(res[1].item) == "c");
+            wassert(actual(index.nearest(set<string>{ "unknown" }, 2).size()) == 0u);
+        });
+
+        add_method("compare", []() {
+            // Compare with a brute force search on the test data
+            Fast coll;
+            load_test_tags(coll);
+
+            SimilarityIndex index(coll, 4);
+            SimilarityIndex serial(coll, 1);
+            unsigned n = 0;
+            for (auto i = coll.begin(); i != coll.end(); ++i, ++n)
+            {
+                if (n % 199) continue;
+                auto expected = brute_force(coll, i->second, 10, i->first);
+                auto res = index.similar(i->first, 10);
+                wassert(actual(res.size()) == expected.size());
+                for (size_t j = 0; j < res.size(); ++j)
+                {
+                    wassert(actual(res[j].item) == expected[j].first);
+                    wassert(actual(res[j].similarity) == expected[j].second);
+                }
+
+                auto res1 = serial.similar(i->first, 10);
+                wassert(actual(res1.size()) == res.size());
+                for (size_t j = 0; j < res.size(); ++j)
+                    wassert(actual(res1[j].item) == res[j].item);
+            }
+        });
+    }
+} test("debtags_coll_similarity");
+
+}
@@ -0,0 +1,212 @@
+/*
+ * Search for items with similar tags
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/similarity.h>
+#include <ept/debtags/coll/fast.h>
+#include <ept/debtags/coll/postings.h>
+#include <ept/utils/parallel.h>
+#include <algorithm>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+namespace {
+
+struct Candidate
+{
+    uint32_t id;
+    /// Number of tags in common with the query
+    unsigned common;
+    /// Number of tags in the union with the query
+    unsigned total;
+
+    /// Compare by decreasing similarity, then increasing item number
+    bool operator<(const Candidate& o) const
+    {
+        // Compare common/total without rounding
+        uint64_t a = (uint64_t)common * o.total;
+        uint64_t b = (uint64_t)o.common * total;
+        if (a != b) return a > b;
+        return id < o.id;
+    }
+};
+
+}
+
+SimilarityIndex::SimilarityIndex(const Fast& coll, unsigned threads)
+{
+    // Number tags and items in sorted order, so that the tags of each item
+    // and the items of each tag come out sorted
+    uint32_t tag_count = 0;
+    tag_ids.reserve(coll.tagCount());
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+        tag_ids.insert(make_pair(t->first, tag_count++));
+
+    vector<Fast::const_iterator> items;
+    items.reserve(coll.itemCount());
+    item_names.reserve(coll.itemCount());
+    item_ids.reserve(coll.itemCount());
+    item_offsets.reserve(coll.itemCount() + 1);
+    item_offsets.push_back(0);
+    for (auto i = coll.begin(); i != coll.end(); ++i)
+    {
+        item_ids.insert(make_pair(i->first, (uint32_t)items.size()));
+        item_names.push_back(i->first);
+        items.push_back(i);
+        item_offsets.push_back(item_offsets.back() + i->second.size());
+    }
+    item_tags.resize(item_offsets.back());
+
+    // Look up the tags of each range of items in parallel, counting how many
+    // items each worker finds for each tag
+    parallel::Partition part(items.size(), threads, 1024);
+    vector<vector<uint32_t>> counts(part.workers, vector<uint32_t>(tag_count, 0));
+    parallel::run(part, [&](size_t w, size_t begin, size_t end) {
+        vector<uint32_t>& count = counts[w];
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t pos = item_offsets[i];
+            for (const auto& t: items[i]->second)
+            {
+                uint32_t id = tag_ids.find(t)->second;
+                item_tags[pos++] = id;
+                ++count[id];
+            }
+        }
+    });
+
+    // Lay out the postings of each tag, and turn the counts into the
+    // position where each worker starts writing its part
+    tag_offsets.resize(tag_count + 1);
+    tag_offsets[0] = 0;
+    for (uint32_t t = 0; t < tag_count; ++t)
+    {
+        uint32_t pos = tag_offsets[t];
+        for (auto& count: counts)
+        {
+            uint32_t c = count[t];
+            count[t] = pos;
+            pos += c;
+        }
+        tag_offsets[t + 1] = pos;
+    }
+    tag_items.resize(tag_offsets.back());
+
+    // Fill the postings in parallel: workers handle ascending ranges of
+    // items, so each posting list comes out sorted
+    parallel::run(part, [&](size_t w, size_t begin, size_t end) {
+        vector<uint32_t>& cursor = counts[w];
+        for (size_t i = begin; i < end; ++i)
+            for (uint32_t pos = item_offsets[i]; pos < item_offsets[i + 1]; ++pos)
+                tag_items[cursor[item_tags[pos]]++] = i;
+    });
+}
+
+std::vector<SimilarityIndex::Match> SimilarityIndex::search(std::vector<uint32_t> tags, size_t size, unsigned k, uint32_t skip) const
+{
+    std::vector<Match> res;
+    if (k == 0 || tags.empty())
+        return res;
+
+    Bitmap query(tag_offsets.size() - 1);
+    for (const auto& t: tags)
+        query.set(t);
+
+    // Rarest tags first
+    sort(tags.begin(), tags.end(), [&](uint32_t a, uint32_t b) {
+        return tag_offsets[a + 1] - tag_offsets[a] < tag_offsets[b + 1] - tag_offsets[b];
+    });
+
+    // Heap of the best k candidates, with the worst one on top
+    vector<Candidate> best;
+    best.reserve(k);
+    Bitmap seen(item_names.size());
+    for (size_t i = 0; i < tags.size(); ++i)
+    {
+        // Items not seen so far have none of the tags before i, so they have
+        // at most tags.size() - i tags in common with the query, and at least
+        // size tags in the union
+        if (best.size() == k && (uint64_t)best.front().common * size > (uint64_t)(tags.size() - i) * best.front().total)
+            break;
+
+        for (uint32_t p = tag_offsets[tags[i]]; p < tag_offsets[tags[i] + 1]; ++p)
+        {
+            uint32_t id = tag_items[p];
+            if (id == skip || seen.test(id))
+                continue;
+            seen.set(id);
+
+            Candidate c;
+            c.id = id;
+            c.common = 0;
+            for (uint32_t t = item_offsets[id]; t < item_offsets[id + 1]; ++t)
+                if (query.test(item_tags[t]))
+                    ++c.common;
+            c.total = size + (item_offsets[id + 1] - item_offsets[id]) - c.common;
+
+            if (best.size() < k)
+            {
+                best.push_back(c);
+                push_heap(best.begin(), best.end());
+            }
+            else if (c < best.front())
+            {
+                pop_heap(best.begin(), best.end());
+                best.back() = c;
+                push_heap(best.begin(), best.end());
+            }
+        }
+    }
+
+    sort_heap(best.begin(), best.end());
+    res.reserve(best.size());
+    for (const auto& c: best)
+        res.push_back(Match{ item_names[c.id], (double)c.common / c.total, c.common });
+    return res;
+}
+
+std::vector<SimilarityIndex::Match> SimilarityIndex::similar(const std::string& item, unsigned k) const
+{
+    auto i = item_ids.find(item);
+    if (i == item_ids.end())
+        return std::vector<Match>();
+    uint32_t id = i->second;
+    std::vector<uint32_t> tags(item_tags.begin() + item_offsets[id], item_tags.begin() + item_offsets[id + 1]);
+    size_t size = tags.size();
+    return search(move(tags), size, k, id);
+}
+
+std::vector<SimilarityIndex::Match> SimilarityIndex::nearest(const std::set<std::string>& tags, unsigned k) const
+{
+    std::vector<uint32_t> ids;
+    ids.reserve(tags.size());
+    for (const auto& t: tags)
+    {
+        auto i = tag_ids.find(t);
+        if (i != tag_ids.end())
+            ids.push_back(i->second);
+    }
+    return search(move(ids), tags.size(), k, (uint32_t)-1);
+}
+
+}
+}
+}
@@ -0,0 +1,111 @@
+#ifndef EPT_DEBTAGS_COLL_SIMILARITY_H
+#define EPT_DEBTAGS_COLL_SIMILARITY_H
+
+/** \file
+ * Search for items with similar tags
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/**
+ * Index to find the items whose tag sets are most similar to a given one.
+ *
+ * Similarity is the Jaccard index of the two tag sets: the number of common
+ * tags divided by the number of tags in either set. Unlike
+ * utils::set_distance, it does not favour items with few tags.
+ *
+ * Items and tags are numbered, and the index stores the tags of each item and
+ * the items of each tag as arrays of numbers. A query scans the items of its
+ * rarest tags first, computing the exact similarity of each new candidate,
+ * and stops as soon as the items not seen yet cannot make it into the top k.
+ */
+class SimilarityIndex
+{
+public:
+    struct Match
+    {
+        std::string item;
+        /// Jaccard index of the tag sets, between 0 and 1
+        double similarity;
+        /// Number of tags in common
+        unsigned common;
+    };
+
+protected:
+    std::vector<std::string> item_names;
+    std::unordered_map<std::string, uint32_t> item_ids;
+    std::unordered_map<std::string, uint32_t> tag_ids;
+
+    /// Tags of item i are item_tags[item_offsets[i]] to item_tags[item_offsets[i + 1]]
+    std::vector<uint32_t> item_offsets;
+    std::vector<uint32_t> item_tags;
+
+    /// Items of tag t are tag_items[tag_offsets[t]] to tag_items[tag_offsets[t + 1]]
+    std::vector<uint32_t> tag_offsets;
+    std::vector<uint32_t> tag_items;
+
+    std::vector<Match> search(std::vector<uint32_t> tags, size_t size, unsigned k, uint32_t skip) const;
+
+public:
+    /**
+     * Index the items of \a coll.
+     *
+     * @param threads
+     *   Number of threads used to build the index, or 0 to use as many as the
+     *   available CPUs
+     */
+    explicit SimilarityIndex(const Fast& coll, unsigned threads = 0);
+    SimilarityIndex(const SimilarityIndex&) = delete;
+    SimilarityIndex& operator=(const SimilarityIndex&) = delete;
+
+    /// Return the number of items
+    size_t itemCount() const { return item_names.size(); }
+
+    /**
+     * Return the \a k items most similar to \a item, excluding \a item itself.
+     *
+     * Results are sorted by decreasing similarity, then by name. Items with
+     * no tags in common are never returned. Returns no results if \a item is
+     * not in the index.
+     */
+    std::vector<Match> similar(const std::string& item, unsigned k) const;
+
+    /**
+     * Return the \a k items whose tags are most similar to \a tags.
+     *
+     * Results are sorted as in similar(). Tags that are not in the index
+     * count as tags that no item matches.
+     */
+    std::vector<Match> nearest(const std::set<std::string>& tags, unsigned k) const;
+};
+
+}
+}
+}
+#endif
@@ -0,0 +1,98 @@
+#include "ept/test.h"
+#include "tagsetindex.h"
+#include "fast.h"
+#include <map>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("index", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x", "y" });
+            coll.insert("b", set<string>{ "x" });
+            coll.insert("c", set<string>{ "y", "x" });
+
+            TagsetIndex index(coll);
+            wassert(actual(index.size()) == 2u);
+
+            unsigned xy = index.find(set<string>{ "x", "y" });
+            wassert(actual(xy) != TagsetIndex::none);
+            wassert_true(index.tagset(xy) == set<string>({ "x", "y" }));
+            wassert(actual(index.itemCount(xy)) == 2u);
+            wassert(actual(*index.items(xy)[0]) == "a");
+            wassert(actual(*index.items(xy)[1]) == "c");
+            wassert(actual(index.tagsetOf("c")) == xy);
+            wassert(actual(index.tagsetOf("b")) == index.find(set<string>{ "x" }));
+
+            wassert(actual(index.find(set<string>{ "y" })) == TagsetIndex::none);
+            wassert(actual(index.find(set<string>())) == TagsetIndex::none);
+            wassert(actual(index.tagsetOf("d")) == TagsetIndex::none);
+
+            wassert_true(index.getItemsExactMatch(set<string>{ "x", "y" }) == set<string>({ "a", "c" }));
+            wassert_true(index.getItemsExactMatch(set<string>{ "y" }).empty());
+        });
+
+        add_method("cache", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x", "y" });
+            wassert_true(coll.getItemsExactMatch(set<string>{ "x", "y" }) == set<string>{ "a" });
+            auto index = coll.tagsetIndex();
+            wassert_true(coll.tagsetIndex() == index);
+
+            // Changing the collection drops the cached index
+            coll.insert("b", set<string>{ "x", "y" });
+            wassert_true(coll.tagsetIndex() != index);
+            wassert_true(coll.getItemsExactMatch(set<string>{ "x", "y" }) == set<string>({ "a", "b" }));
+
+            coll.removeTag("y");
+            wassert_true(coll.getItemsExactMatch(set<string>{ "x", "y" }).empty());
+            wassert_true(coll.getItemsExactMatch(set<string>{ "x" }) == set<string>({ "a", "b" }));
+
+            // The old index is a snapshot and still works
+            wassert(actual(index->size()) == 1u);
+            wassert(actual(index->itemCount(0)) == 1u);
+        });
+
+        add_method("exact_match", []() {
+            // Compare with grouping items by tag set on the test data
+            Fast coll;
+            load_test_tags(coll);
+
+            map<set<string>, set<string>> groups;
+            for (const auto& i: coll)
+                groups[i.second].insert(i.first);
+
+            // Query without the index, then with it
+            for (const auto& g: groups)
+                wassert_true(coll.getItemsExactMatch(g.first) == g.second);
+
+            auto index = coll.tagsetIndex();
+            wassert(actual(index->size()) < coll.itemCount());
+            wassert(actual(index->size()) == groups.size());
+            size_t total = 0;
+            for (unsigned id = 0; id < index->size(); ++id)
+                total += index->itemCount(id);
+            wassert(actual(total) == coll.itemCount());
+
+            for (const auto& g: groups)
+                wassert_true(coll.getItemsExactMatch(g.first) == g.second);
+
+            // Iterating does not drop the index
+            for (const auto& i: coll)
+                (void)i;
+            wassert_true(coll.tagsetIndex() == index);
+        });
+    }
+} test("debtags_coll_tagsetindex");
+
+}
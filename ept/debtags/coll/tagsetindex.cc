@@ -0,0 +1,78 @@
+/*
+ * Index of the distinct tag sets of a tag collection
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/tagsetindex.h>
+#include <ept/debtags/coll/fast.h>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+const unsigned TagsetIndex::none;
+
+TagsetIndex::TagsetIndex(const Fast& coll)
+{
+    item_tagsets.reserve(coll.itemCount());
+    for (const auto& i: coll)
+    {
+        auto res = ids.insert(make_pair(i.second, (unsigned)tagsets.size()));
+        if (res.second)
+        {
+            tagsets.push_back(&res.first->first);
+            members.emplace_back();
+        }
+        unsigned id = res.first->second;
+
+        // Items come sorted from coll, so members stay sorted
+        auto item = item_tagsets.insert(make_pair(i.first, id)).first;
+        members[id].push_back(&item->first);
+    }
+}
+
+unsigned TagsetIndex::find(const std::set<std::string>& tags) const
+{
+    auto i = ids.find(tags);
+    if (i == ids.end())
+        return none;
+    return i->second;
+}
+
+unsigned TagsetIndex::tagsetOf(const std::string& item) const
+{
+    auto i = item_tagsets.find(item);
+    if (i == item_tagsets.end())
+        return none;
+    return i->second;
+}
+
+std::set<std::string> TagsetIndex::getItemsExactMatch(const std::set<std::string>& tags) const
+{
+    std::set<std::string> res;
+    unsigned id = find(tags);
+    if (id == none)
+        return res;
+    for (const auto& i: members[id])
+        res.insert(res.end(), *i);
+    return res;
+}
+
+}
+}
+}
@@ -0,0 +1,110 @@
+#ifndef EPT_DEBTAGS_COLL_TAGSETINDEX_H
+#define EPT_DEBTAGS_COLL_TAGSETINDEX_H
+
+/** \file
+ * Index of the distinct tag sets of a tag collection
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <set>
+#include <string>
+#include <vector>
+#include <functional>
+#include <unordered_map>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/// Hash function for tag sets, given as sorted containers of tags or tag IDs
+struct TagsetHash
+{
+    template<typename Container>
+    size_t operator()(const Container& tags) const
+    {
+        std::hash<typename Container::value_type> hasher;
+        size_t res = tags.size();
+        for (const auto& t: tags)
+            res ^= hasher(t) + 0x9e3779b9 + (res << 6) + (res >> 2);
+        return res;
+    }
+};
+
+/**
+ * Group the items of a collection by their tag set.
+ *
+ * Each distinct tag set is stored once and numbered with a tag set ID, from 0
+ * to size() - 1. Looking up the items with an exact tag set is a single hash
+ * lookup.
+ *
+ * Fast::getItemsExactMatch() answers from this index after Fast::tagsetIndex()
+ * has built it.
+ */
+class TagsetIndex
+{
+public:
+    /// ID returned when a tag set or item is not in the index
+    static const unsigned none = (unsigned)-1;
+
+protected:
+    /// Distinct tag sets, mapped to their ID
+    std::unordered_map<std::set<std::string>, unsigned, TagsetHash> ids;
+
+    /// Tag sets by ID, pointing to the keys of ids
+    std::vector<const std::set<std::string>*> tagsets;
+
+    /// Tag set ID of each item
+    std::unordered_map<std::string, unsigned> item_tagsets;
+
+    /// Items of each tag set, sorted, pointing to the keys of item_tagsets
+    std::vector<std::vector<const std::string*>> members;
+
+public:
+    /// Index the items of \a coll
+    explicit TagsetIndex(const Fast& coll);
+    TagsetIndex(const TagsetIndex&) = delete;
+    TagsetIndex& operator=(const TagsetIndex&) = delete;
+
+    /// Return the number of distinct tag sets
+    size_t size() const { return tagsets.size(); }
+
+    /// Return a tag set given its ID
+    const std::set<std::string>& tagset(unsigned id) const { return *tagsets[id]; }
+
+    /// Return the names of the items with the given tag set, sorted
+    const std::vector<const std::string*>& items(unsigned id) const { return members[id]; }
+
+    /// Return the number of items with the given tag set
+    size_t itemCount(unsigned id) const { return members[id].size(); }
+
+    /// Return the ID of a tag set, or none if no item has exactly those tags
+    unsigned find(const std::set<std::string>& tags) const;
+
+    /// Return the ID of the tag set of an item, or none if the item is unknown
+    unsigned tagsetOf(const std::string& item) const;
+
+    /// Return the items which have the exact tag set \a tags
+    std::set<std::string> getItemsExactMatch(const std::set<std::string>& tags) const;
+};
+
+}
+}
+}
+#endif
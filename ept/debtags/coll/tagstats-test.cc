@@ -0,0 +1,145 @@
+#include "ept/test.h"
+#include "tagstats.h"
+#include "fast.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("counts", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x", "y", "z" });
+            coll.insert("b", set<string>{ "x", "y" });
+            coll.insert("c", set<string>{ "x", "w" });
+            coll.insert("d", set<string>{ "w" });
+
+            TagStats stats(coll, 2);
+            wassert(actual(stats.itemCount()) == 4u);
+            wassert(actual(stats.count("x")) == 3u);
+            wassert(actual(stats.count("x", "y")) == 2u);
+            wassert(actual(stats.count("y", "x")) == 2u);
+            wassert(actual(stats.count("z", "w")) == 0u);
+            wassert(actual(stats.count("missing")) == 0u);
+
+            // Items with y always have x
+            auto res = stats.suggest(set<string>{ "y" }, 10);
+            wassert(actual(res.size()) == 2u);
+            wassert(actual(res[0].tag) == "x");
+            wassert(actual(res[0].count) == 2u);
+            wassert(actual(res[0].confidence) == 1.0);
+            wassert(actual(res[0].lift) == 4.0 / 3.0);
+            wassert(actual(res[1].tag) == "z");
+            wassert(actual(res[1].confidence) == 0.5);
+
+            // Ranking by lift favours the rarer z
+            res = stats.suggest(set<string>{ "y" }, 1, TagStats::LIFT);
+            wassert(actual(res.size()) == 1u);
+            wassert(actual(res[0].tag) == "z");
+            wassert(actual(res[0].lift) == 2.0);
+
+            res = stats.suggest(set<string>{ "x", "y" }, 10);
+            wassert(actual(res.size()) == 1u);
+            wassert(actual(res[0].tag) == "z");
+            wassert(actual(res[0].confidence) == 0.5);
+
+            wassert(actual(stats.suggest(set<string>{ "y" }, 10, TagStats::CONFIDENCE, 2).size()) == 1u);
+            wassert(actual(stats.suggest(set<string>{ "y", "w" }, 10).size()) == 0u);
+            wassert(actual(stats.suggest(set<string>{ "missing" }, 10).size()) == 0u);
+            wassert(actual(stats.suggest(set<string>(), 1)[0].tag) == "x");
+        });
+
+        add_method("update", []() {
+            Fast coll;
+            TagStats stats;
+            stats.insert(coll, "a", set<string>{ "x", "y" });
+            stats.insert(coll, "b", set<string>{ "x" });
+            stats.insert(coll, "b", set<string>{ "z" });
+            stats.insert(coll, "b", set<string>{ "x" });
+            wassert(actual(stats.itemCount()) == 2u);
+            wassert(actual(stats.count("x")) == 2u);
+            wassert(actual(stats.count("x", "z")) == 1u);
+            wassert(actual(stats.count("y", "z")) == 0u);
+            wassert(actual(stats.suggest(set<string>{ "x", "z" }, 10).size()) == 0u);
+            wassert(actual(stats.suggest(set<string>{ "x", "y" }, 10).size()) == 0u);
+            wassert(actual(stats.suggest(set<string>{ "x" }, 10).size()) == 2u);
+
+            stats.remove(set<string>{ "x", "z" });
+            wassert(actual(stats.itemCount()) == 1u);
+            wassert(actual(stats.count("x", "z")) == 0u);
+            wassert(actual(stats.suggest(set<string>{ "z" }, 10).size()) == 0u);
+
+            bool failed = false;
+            try {
+                stats.remove(set<string>{ "x", "z" });
+            } catch (std::runtime_error&) {
+                failed = true;
+            }
+            wassert_true(failed);
+
+            // Tag sets that were emptied can be counted again
+            stats.add(set<string>{ "x", "z" });
+            stats.add(set<string>{ "x", "y", "z" });
+            auto res = stats.suggest(set<string>{ "x", "z" }, 10);
+            wassert(actual(res.size()) == 1u);
+            wassert(actual(res[0].tag) == "y");
+            wassert(actual(res[0].count) == 1u);
+        });
+
+        add_method("compare", []() {
+            // Compare with intersecting item sets on the test data
+            Fast coll;
+            load_test_tags(coll);
+            TagStats stats(coll, 3);
+
+            size_t card;
+            string top = coll.findTagWithMaxCardinality(card);
+            const char* queries[][2] = {
+                { "role::program", nullptr },
+                { "role::program", "interface::x11" },
+                { "implemented-in::c", "uitoolkit::gtk" },
+            };
+            for (const auto& q: queries)
+            {
+                set<string> tags;
+                for (const auto& t: q)
+                    if (t) tags.insert(t);
+                set<string> items = coll.getItemsHavingTags(tags);
+                for (const auto& s: stats.suggest(tags, 20))
+                {
+                    set<string> with = coll.getItemsHavingTag(s.tag);
+                    unsigned joint = 0;
+                    for (const auto& i: items)
+                        if (with.find(i) != with.end())
+                            ++joint;
+                    wassert(actual(s.count) == joint);
+                    wassert(actual(s.confidence) == (double)joint / items.size());
+                }
+            }
+            wassert(actual(stats.count(top)) == card);
+
+            // Building incrementally gives the same counts
+            TagStats incremental;
+            for (const auto& i: coll)
+                incremental.add(i.second);
+            auto a = stats.suggest(set<string>{ top }, 50, TagStats::LIFT);
+            auto b = incremental.suggest(set<string>{ top }, 50, TagStats::LIFT);
+            wassert(actual(a.size()) == b.size());
+            for (size_t i = 0; i < a.size(); ++i)
+            {
+                wassert(actual(a[i].tag) == b[i].tag);
+                wassert(actual(a[i].count) == b[i].count);
+            }
+        });
+    }
+} test("debtags_coll_tagstats");
+
+}
@@ -0,0 +1,291 @@
+/*
+ * Tag co-occurrence statistics and tag suggestions
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/tagstats.h>
+#include <ept/debtags/coll/fast.h>
+#include <ept/utils/parallel.h>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+TagStats::TagStats(const Fast& coll, unsigned threads)
+{
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+        obtainTag(t->first);
+
+    vector<Fast::const_iterator> all;
+    all.reserve(coll.itemCount());
+    for (auto i = coll.begin(); i != coll.end(); ++i)
+        all.push_back(i);
+    items = all.size();
+
+    // Count ranges of items in parallel, then merge the partial counts
+    parallel::Partition part(all.size(), threads, 1024);
+    struct Partial
+    {
+        vector<unsigned> tag_counts;
+        /// Pair counts, keyed by (lower tag ID << 32) | higher tag ID
+        unordered_map<uint64_t, unsigned> pair_counts;
+        unordered_map<Tagset, unsigned, TagsetHash> tagset_counts;
+    };
+    vector<Partial> partials(part.workers);
+    for (auto& p: partials)
+        p.tag_counts.resize(tag_names.size());
+    parallel::run(part, [&](size_t w, size_t begin, size_t end) {
+        Partial& p = partials[w];
+        Tagset tags;
+        for (size_t i = begin; i < end; ++i)
+        {
+            tags.clear();
+            for (const auto& t: all[i]->second)
+                tags.push_back(tag_ids.find(t)->second);
+            sort(tags.begin(), tags.end());
+            for (size_t a = 0; a < tags.size(); ++a)
+            {
+                ++p.tag_counts[tags[a]];
+                for (size_t b = a + 1; b < tags.size(); ++b)
+                    ++p.pair_counts[(uint64_t)tags[a] << 32 | tags[b]];
+            }
+            ++p.tagset_counts[tags];
+        }
+    });
+
+    for (const auto& p: partials)
+    {
+        for (size_t t = 0; t < tag_counts.size(); ++t)
+            tag_counts[t] += p.tag_counts[t];
+        for (const auto& c: p.pair_counts)
+        {
+            uint32_t a = c.first >> 32;
+            uint32_t b = c.first & 0xffffffff;
+            pair_counts[a][b] += c.second;
+            pair_counts[b][a] += c.second;
+        }
+        for (const auto& c: p.tagset_counts)
+        {
+            auto res = tagset_counts.insert(make_pair(c.first, 0u));
+            if (res.second)
+                for (const auto& t: c.first)
+                    tagsets_of[t].push_back(&*res.first);
+            res.first->second += c.second;
+        }
+    }
+}
+
+uint32_t TagStats::obtainTag(const std::string& tag)
+{
+    auto res = tag_ids.insert(make_pair(tag, (uint32_t)tag_names.size()));
+    if (res.second)
+    {
+        tag_names.push_back(tag);
+        tag_counts.push_back(0);
+        pair_counts.emplace_back();
+        tagsets_of.emplace_back();
+    }
+    return res.first->second;
+}
+
+bool TagStats::find(const std::set<std::string>& tags, Tagset& res) const
+{
+    res.clear();
+    for (const auto& t: tags)
+    {
+        auto i = tag_ids.find(t);
+        if (i == tag_ids.end())
+            return false;
+        res.push_back(i->second);
+    }
+    sort(res.begin(), res.end());
+    return true;
+}
+
+void TagStats::count(const Tagset& tags, int delta)
+{
+    items += delta;
+    for (size_t a = 0; a < tags.size(); ++a)
+    {
+        tag_counts[tags[a]] += delta;
+        for (size_t b = a + 1; b < tags.size(); ++b)
+        {
+            // Keep the pair counts sparse
+            if ((pair_counts[tags[a]][tags[b]] += delta) == 0)
+            {
+                pair_counts[tags[a]].erase(tags[b]);
+                pair_counts[tags[b]].erase(tags[a]);
+            }
+            else
+                pair_counts[tags[b]][tags[a]] += delta;
+        }
+    }
+
+    auto res = tagset_counts.insert(make_pair(tags, 0u));
+    if (res.second)
+        for (const auto& t: tags)
+            tagsets_of[t].push_back(&*res.first);
+    if ((res.first->second += delta) != 0)
+        return;
+
+    // Forget tag sets that no item has anymore
+    for (const auto& t: tags)
+    {
+        auto& of = tagsets_of[t];
+        *std::find(of.begin(), of.end(), &*res.first) = of.back();
+        of.pop_back();
+    }
+    tagset_counts.erase(res.first);
+}
+
+unsigned TagStats::count(const std::string& tag) const
+{
+    auto i = tag_ids.find(tag);
+    if (i == tag_ids.end())
+        return 0;
+    return tag_counts[i->second];
+}
+
+unsigned TagStats::count(const std::string& tag1, const std::string& tag2) const
+{
+    auto a = tag_ids.find(tag1);
+    auto b = tag_ids.find(tag2);
+    if (a == tag_ids.end() || b == tag_ids.end())
+        return 0;
+    if (a == b)
+        return tag_counts[a->second];
+    const auto& pairs = pair_counts[a->second];
+    auto i = pairs.find(b->second);
+    if (i == pairs.end())
+        return 0;
+    return i->second;
+}
+
+void TagStats::add(const std::set<std::string>& tags)
+{
+    if (tags.empty())
+        return;
+    Tagset ids;
+    for (const auto& t: tags)
+        ids.push_back(obtainTag(t));
+    sort(ids.begin(), ids.end());
+    count(ids, 1);
+}
+
+void TagStats::remove(const std::set<std::string>& tags)
+{
+    if (tags.empty())
+        return;
+    Tagset ids;
+    auto i = tagset_counts.end();
+    if (find(tags, ids))
+        i = tagset_counts.find(ids);
+    if (i == tagset_counts.end())
+        throw std::runtime_error("cannot remove a tag set that has not been counted");
+    count(ids, -1);
+}
+
+void TagStats::insert(Fast& coll, const std::string& item, const std::set<std::string>& tags)
+{
+    std::set<std::string> before = coll.getTagsOfItem(item);
+    coll.insert(item, tags);
+    std::set<std::string> after = coll.getTagsOfItem(item);
+    if (after.size() == before.size())
+        return;
+    remove(before);
+    add(after);
+}
+
+std::vector<TagStats::Suggestion> TagStats::suggest(const std::set<std::string>& tags, unsigned k, Ranking ranking, unsigned min_count) const
+{
+    std::vector<Suggestion> res;
+    Tagset query;
+    if (k == 0 || !find(tags, query))
+        return res;
+
+    // Count the items with the query tags, and how many of them have each
+    // other tag
+    unsigned support = 0;
+    vector<pair<uint32_t, unsigned>> joint;
+    if (query.empty())
+    {
+        support = items;
+        for (uint32_t t = 0; t < tag_counts.size(); ++t)
+            joint.push_back(make_pair(t, tag_counts[t]));
+    }
+    else if (query.size() == 1)
+    {
+        support = tag_counts[query[0]];
+        joint.assign(pair_counts[query[0]].begin(), pair_counts[query[0]].end());
+    }
+    else
+    {
+        // Go through the tag sets containing the rarest query tag
+        uint32_t rarest = *min_element(query.begin(), query.end(), [&](uint32_t a, uint32_t b) {
+            return tag_counts[a] < tag_counts[b];
+        });
+        vector<unsigned> counts(tag_names.size(), 0);
+        for (const auto& ts: tagsets_of[rarest])
+        {
+            if (!includes(ts->first.begin(), ts->first.end(), query.begin(), query.end()))
+                continue;
+            support += ts->second;
+            for (const auto& t: ts->first)
+                counts[t] += ts->second;
+        }
+        for (uint32_t t = 0; t < counts.size(); ++t)
+            if (counts[t] && !binary_search(query.begin(), query.end(), t))
+                joint.push_back(make_pair(t, counts[t]));
+    }
+    if (support == 0)
+        return res;
+
+    for (const auto& j: joint)
+    {
+        if (j.second < min_count || j.second == 0)
+            continue;
+        Suggestion s;
+        s.tag = tag_names[j.first];
+        s.count = j.second;
+        s.confidence = (double)j.second / support;
+        s.lift = s.confidence * items / tag_counts[j.first];
+        res.push_back(s);
+    }
+
+    auto better = [&](const Suggestion& a, const Suggestion& b) {
+        double ka = ranking == LIFT ? a.lift : a.confidence;
+        double kb = ranking == LIFT ? b.lift : b.confidence;
+        if (ka != kb) return ka > kb;
+        if (a.count != b.count) return a.count > b.count;
+        return a.tag < b.tag;
+    };
+    if (res.size() > k)
+    {
+        partial_sort(res.begin(), res.begin() + k, res.end(), better);
+        res.resize(k);
+    }
+    else
+        sort(res.begin(), res.end(), better);
+    return res;
+}
+
+}
+}
+}
@@ -0,0 +1,154 @@
+#ifndef EPT_DEBTAGS_COLL_TAGSTATS_H
+#define EPT_DEBTAGS_COLL_TAGSTATS_H
+
+/** \file
+ * Tag co-occurrence statistics and tag suggestions
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/tagsetindex.h>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+class Fast;
+
+/**
+ * Counts of how often tags appear together, to suggest tags that usually go
+ * with a given set: "items with A and B usually also have C".
+ *
+ * For each tag it keeps the number of items having it and, sparsely, the
+ * number of items having it together with each other tag. It also counts
+ * the items of each distinct tag set, to answer queries about more than one
+ * tag exactly.
+ *
+ * The statistics can be kept up to date with add() and remove(), or with
+ * insert() when adding tags to a Fast collection.
+ */
+class TagStats
+{
+public:
+    /// How to rank suggestions
+    enum Ranking
+    {
+        /// Fraction of the items with the given tags that also have the suggestion
+        CONFIDENCE,
+        /// Confidence divided by the fraction of all items with the suggestion
+        LIFT,
+    };
+
+    struct Suggestion
+    {
+        std::string tag;
+        /// Number of items with the given tags and the suggested tag
+        unsigned count;
+        double confidence;
+        double lift;
+    };
+
+protected:
+    typedef std::vector<uint32_t> Tagset;
+
+    /// Number of items
+    unsigned items = 0;
+
+    std::unordered_map<std::string, uint32_t> tag_ids;
+    std::vector<std::string> tag_names;
+
+    /// Number of items with each tag
+    std::vector<unsigned> tag_counts;
+
+    /// For each tag, the number of items it shares with each other tag
+    std::vector<std::unordered_map<uint32_t, unsigned>> pair_counts;
+
+    /// Number of items with each distinct tag set, which is never 0
+    std::unordered_map<Tagset, unsigned, TagsetHash> tagset_counts;
+
+    /// Tag sets containing each tag, pointing into tagset_counts
+    std::vector<std::vector<const std::pair<const Tagset, unsigned>*>> tagsets_of;
+
+    uint32_t obtainTag(const std::string& tag);
+
+    /// Return the sorted IDs of \a tags, or false if a tag is unknown
+    bool find(const std::set<std::string>& tags, Tagset& res) const;
+
+    /// Count an item with the given tags \a delta times
+    void count(const Tagset& tags, int delta);
+
+public:
+    TagStats() {}
+
+    /**
+     * Compute the statistics of \a coll.
+     *
+     * @param threads
+     *   Number of threads used to count, or 0 to use as many as the available
+     *   CPUs
+     */
+    explicit TagStats(const Fast& coll, unsigned threads = 0);
+
+    /// Return the number of items counted
+    unsigned itemCount() const { return items; }
+
+    /// Return the number of items with \a tag
+    unsigned count(const std::string& tag) const;
+
+    /// Return the number of items with both \a tag1 and \a tag2
+    unsigned count(const std::string& tag1, const std::string& tag2) const;
+
+    /// Count an item with the given tags
+    void add(const std::set<std::string>& tags);
+
+    /**
+     * Stop counting an item with the given tags.
+     *
+     * Throws std::runtime_error if no item with those tags has been counted.
+     */
+    void remove(const std::set<std::string>& tags);
+
+    /**
+     * Add tags to an item in \a coll as with Fast::insert, and update the
+     * statistics accordingly
+     */
+    void insert(Fast& coll, const std::string& item, const std::set<std::string>& tags);
+
+    /**
+     * Suggest the tags that most often go with \a tags.
+     *
+     * @param k
+     *   Maximum number of suggestions to return
+     * @param ranking
+     *   How to sort the suggestions: ties are sorted by count, then by tag
+     *   name
+     * @param min_count
+     *   Ignore tags found together with \a tags in fewer items than this,
+     *   since lift is unreliable on rare tags
+     */
+    std::vector<Suggestion> suggest(const std::set<std::string>& tags, unsigned k, Ranking ranking = CONFIDENCE, unsigned min_count = 1) const;
+};
+
+}
+}
+}
+#endif
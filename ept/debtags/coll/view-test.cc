@@ -0,0 +1,132 @@
+#include "ept/test.h"
+#include "view.h"
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+using namespace ept::debtags::coll;
+
+namespace {
+
+// Child collection computed by copying, as a reference for the view
+Fast copy_child(const Fast& coll, const std::string& tag)
+{
+    Fast res;
+    for (const auto& i: coll.getItemsHavingTag(tag))
+        res.insert(i, coll.getTagsOfItem(i));
+    res.removeTag(tag);
+    return res;
+}
+
+// Check that a view answers queries like the collection it stands for
+void check_same(const View& view, const Fast& coll)
+{
+    wassert(actual(view.itemCount()) == coll.itemCount());
+    wassert(actual(view.tagCount()) == coll.tagCount());
+    wassert(actual(view.empty()) == coll.empty());
+    wassert_true(view.getTaggedItems() == coll.getTaggedItems());
+    wassert_true(view.getAllTags() == coll.getAllTags());
+    wassert_true(view.getAllTagsAsVector() == coll.getAllTagsAsVector());
+
+    size_t vcard, ccard;
+    wassert(actual(view.findTagWithMaxCardinality(vcard)) == coll.findTagWithMaxCardinality(ccard));
+    wassert(actual(vcard) == ccard);
+
+    // Per-item and per-tag queries are checked on a sample, to keep the test
+    // fast on the full test data
+    size_t step = coll.itemCount() / 50 + 1;
+    size_t n = 0;
+    for (const auto& i: coll)
+    {
+        if (n++ % step) continue;
+        wassert_true(view.hasItem(i.first));
+        wassert_true(view.getTagsOfItem(i.first) == i.second);
+        wassert_true(view.getItemsHavingTags(i.second) == coll.getItemsHavingTags(i.second));
+        wassert_true(view.getItemsExactMatch(i.second) == coll.getItemsExactMatch(i.second));
+    }
+    step = coll.tagCount() / 50 + 1;
+    n = 0;
+    for (auto t = coll.tagBegin(); t != coll.tagEnd(); ++t)
+    {
+        if (n++ % step) continue;
+        wassert_true(view.hasTag(t->first));
+        wassert(actual(view.getCardinality(t->first)) == t->second.size());
+        wassert_true(view.getItemsHavingTag(t->first) == t->second);
+        wassert_true(view.getTagsImplying(t->first) == coll.getTagsImplying(t->first));
+    }
+}
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("small", []() {
+            Fast coll;
+            coll.insert("a", set<string>{ "x", "y" });
+            coll.insert("b", set<string>{ "x" });
+            coll.insert("c", set<string>{ "y", "z" });
+
+            View root(coll);
+            wassert(actual(root.itemCount()) == 3u);
+            wassert(actual(root.tagCount()) == 3u);
+
+            // "b" only has the tag that is removed, and disappears
+            View child = root.getChildView("x");
+            wassert(actual(child.itemCount()) == 1u);
+            wassert_true(child.hasItem("a"));
+            wassert_false(child.hasItem("b"));
+            wassert_false(child.hasItem("c"));
+            wassert_false(child.hasTag("x"));
+            wassert_true(child.hasTag("y"));
+            wassert_false(child.hasTag("z"));
+            wassert_true(child.getTagsOfItem("a") == set<string>{ "y" });
+            wassert_true(child.getItemsHavingTag("x").empty());
+            wassert_true(child.getItemsHavingTags(set<string>{ "x", "y" }).empty());
+
+            View grandchild = child.getChildView("y");
+            wassert_true(grandchild.empty());
+            wassert(actual(grandchild.tagCount()) == 0u);
+
+            wassert_true(root.getChildView("missing").empty());
+
+            Fast copy = child.toFast();
+            wassert(actual(copy.itemCount()) == 1u);
+            wassert_true(copy.getTagsOfItem("a") == set<string>{ "y" });
+        });
+
+        add_method("drill_down", []() {
+            Fast coll;
+            load_test_tags(coll);
+
+            // Follow the tag with the largest cardinality down a few levels,
+            // comparing the view with the copied collection at each step
+            View view(coll);
+            Fast copy = coll;
+            for (unsigned level = 0; level < 3 && !copy.empty(); ++level)
+            {
+                size_t card;
+                string tag = copy.findTagWithMaxCardinality(card);
+                view = view.getChildView(tag);
+                copy = copy_child(copy, tag);
+                wassert(check_same(view, copy));
+            }
+        });
+
+        add_method("child_collection", []() {
+            Fast coll;
+            load_test_tags(coll);
+            size_t card;
+            string tag = coll.findTagWithMaxCardinality(card);
+            Fast child = coll.getChildCollection(tag);
+            Fast expected = copy_child(coll, tag);
+            wassert(actual(child.itemCount()) == expected.itemCount());
+            wassert(actual(child.tagCount()) == expected.tagCount());
+            for (const auto& i: expected)
+                wassert_true(child.getTagsOfItem(i.first) == i.second);
+        });
+    }
+} test("debtags_coll_view");
+
+}
@@ -0,0 +1,318 @@
+/*
+ * Filtered read-only view of a tag collection
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/view.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+using namespace std;
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+namespace {
+
+struct ItemLess
+{
+    bool operator()(const Fast::const_iterator& a, const std::string& b) const { return a->first < b; }
+};
+
+/// Return true if the item has at least one tag not in \a excluded
+bool hasVisibleTags(Fast::const_iterator item, const std::set<std::string>& excluded)
+{
+    for (const auto& t: item->second)
+        if (excluded.find(t) == excluded.end())
+            return true;
+    return false;
+}
+
+}
+
+View::View(const Fast& base)
+    : base(&base)
+{
+    items.reserve(base.items.size());
+    for (auto i = base.items.begin(); i != base.items.end(); ++i)
+        items.push_back(i);
+}
+
+std::vector<Fast::const_iterator>::const_iterator View::findItem(const std::string& item) const
+{
+    auto i = lower_bound(items.begin(), items.end(), item, ItemLess());
+    if (i == items.end() || (*i)->first != item)
+        return items.end();
+    return i;
+}
+
+template<typename FUN>
+void View::countTags(FUN fun) const
+{
+    if (excluded.empty() && items.size() == base->items.size())
+    {
+        // Nothing is filtered: use the cardinalities of the base collection
+        for (const auto& t: base->tags)
+            fun(t.first, t.second.size());
+        return;
+    }
+
+    // Keys point into the tag sets of the base collection, to avoid copying
+    // the tag names
+    std::map<std::reference_wrapper<const std::string>, size_t, std::less<std::string>> counts;
+    for (const auto& i: items)
+        for (const auto& t: i->second)
+            if (visible(t))
+                ++counts[std::cref(t)];
+    for (const auto& c: counts)
+        fun(c.first, c.second);
+}
+
+std::set<std::string> View::getTagsOfItem(const std::string& item) const
+{
+    std::set<std::string> res;
+    auto i = findItem(item);
+    if (i == items.end())
+        return res;
+    for (const auto& t: (*i)->second)
+        if (visible(t))
+            res.insert(res.end(), t);
+    return res;
+}
+
+std::set<std::string> View::getItemsHavingTag(const std::string& tag) const
+{
+    std::set<std::string> res;
+    if (!visible(tag))
+        return res;
+    auto t = base->tags.find(tag);
+    if (t == base->tags.end())
+        return res;
+    for (const auto& i: t->second)
+        if (hasItem(i))
+            res.insert(res.end(), i);
+    return res;
+}
+
+std::set<std::string> View::getItemsHavingTags(const std::set<std::string>& tags) const
+{
+    if (tags.empty())
+        return std::set<std::string>();
+
+    auto i = tags.begin();
+    auto res = getItemsHavingTag(*i);
+    for (++i; i != tags.end() && !res.empty(); ++i)
+    {
+        if (!visible(*i))
+            return std::set<std::string>();
+        auto t = base->tags.find(*i);
+        if (t == base->tags.end())
+            return std::set<std::string>();
+        for (auto j = res.begin(); j != res.end(); )
+            if (t->second.find(*j) == t->second.end())
+                j = res.erase(j);
+            else
+                ++j;
+    }
+    return res;
+}
+
+bool View::hasTag(const std::string& tag) const
+{
+    if (!visible(tag))
+        return false;
+    auto t = base->tags.find(tag);
+    if (t == base->tags.end())
+        return false;
+    for (const auto& i: t->second)
+        if (hasItem(i))
+            return true;
+    return false;
+}
+
+std::set<std::string> View::getTaggedItems() const
+{
+    std::set<std::string> res;
+    for (const auto& i: items)
+        res.insert(res.end(), i->first);
+    return res;
+}
+
+std::set<std::string> View::getAllTags() const
+{
+    std::set<std::string> res;
+    countTags([&](const std::string& tag, size_t) { res.insert(res.end(), tag); });
+    return res;
+}
+
+std::vector<std::string> View::getAllTagsAsVector() const
+{
+    std::vector<std::string> res;
+    countTags([&](const std::string& tag, size_t) { res.push_back(tag); });
+    return res;
+}
+
+unsigned int View::tagCount() const
+{
+    unsigned int res = 0;
+    countTags([&](const std::string&, size_t) { ++res; });
+    return res;
+}
+
+size_t View::getCardinality(const std::string& tag) const
+{
+    if (!visible(tag))
+        return 0;
+    auto t = base->tags.find(tag);
+    if (t == base->tags.end())
+        return 0;
+    size_t res = 0;
+    for (const auto& i: t->second)
+        if (hasItem(i))
+            ++res;
+    return res;
+}
+
+std::set<std::string> View::getTagsImplying(const std::string& tag) const
+{
+    // tag1 implies tag if every item with tag1 also has tag: collect the tags
+    // of the items with tag, then drop those that also appear on an item
+    // without it
+    std::set<std::string> candidates;
+    std::set<std::string> ruled_out;
+    for (const auto& i: items)
+    {
+        bool has_tag = visible(tag) && i->second.find(tag) != i->second.end();
+        std::set<std::string>& dest = has_tag ? candidates : ruled_out;
+        for (const auto& t: i->second)
+            if (visible(t))
+                dest.insert(t);
+    }
+    std::set<std::string> res;
+    set_difference(candidates.begin(), candidates.end(), ruled_out.begin(), ruled_out.end(),
+                   inserter(res, res.end()));
+    res.erase(tag);
+    return res;
+}
+
+std::set<std::string> View::getItemsExactMatch(const std::set<std::string>& tags) const
+{
+    std::set<std::string> res = getItemsHavingTags(tags);
+    for (auto i = res.begin(); i != res.end(); )
+    {
+        // The item has all of tags: it is an exact match if it has no other
+        // visible tags
+        auto item = *findItem(*i);
+        size_t count = 0;
+        for (const auto& t: item->second)
+            if (visible(t))
+                ++count;
+        if (count != tags.size())
+            i = res.erase(i);
+        else
+            ++i;
+    }
+    return res;
+}
+
+std::string View::findTagWithMaxCardinality(size_t& card) const
+{
+    card = 0;
+    std::string res;
+    countTags([&](const std::string& tag, size_t count) {
+        if (count > card)
+        {
+            card = count;
+            res = tag;
+        }
+    });
+    return res;
+}
+
+View View::getChildView(const std::string& tag) const
+{
+    View res;
+    res.base = base;
+    res.excluded = excluded;
+    res.excluded.insert(tag);
+
+    if (!visible(tag))
+        return res;
+    auto t = base->tags.find(tag);
+    if (t == base->tags.end())
+        return res;
+
+    auto add = [&](Fast::const_iterator item) {
+        if (hasVisibleTags(item, res.excluded))
+            res.items.push_back(item);
+    };
+
+    // Intersect the visible items with the items having the tag: look up
+    // each item of the tag if there are comparatively few, else merge the two
+    // sorted sequences
+    const std::set<std::string>& tagged = t->second;
+    if (tagged.size() * log2(items.size() + 1) < items.size())
+    {
+        auto a = items.begin();
+        for (const auto& name: tagged)
+        {
+            a = lower_bound(a, items.end(), name, ItemLess());
+            if (a == items.end())
+                break;
+            if ((*a)->first == name)
+                add(*a);
+        }
+    } else {
+        auto a = items.begin();
+        auto b = tagged.begin();
+        while (a != items.end() && b != tagged.end())
+        {
+            int cmp = (*a)->first.compare(*b);
+            if (cmp < 0)
+                ++a;
+            else if (cmp > 0)
+                ++b;
+            else
+            {
+                add(*a);
+                ++a;
+                ++b;
+            }
+        }
+    }
+
+    return res;
+}
+
+Fast View::toFast() const
+{
+    Fast res;
+    for (const auto& i: items)
+    {
+        std::set<std::string> tags;
+        for (const auto& t: i->second)
+            if (visible(t))
+                tags.insert(tags.end(), t);
+        res.insert(i->first, tags);
+    }
+    return res;
+}
+
+}
+}
+}
@@ -0,0 +1,134 @@
+#ifndef EPT_DEBTAGS_COLL_VIEW_H
+#define EPT_DEBTAGS_COLL_VIEW_H
+
+/** \file
+ * Filtered read-only view of a tag collection
+ */
+
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#include <ept/debtags/coll/fast.h>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace ept {
+namespace debtags {
+namespace coll {
+
+/**
+ * Read-only view of a subset of a Fast collection.
+ *
+ * A view is made of a base collection, the subset of its items that are
+ * visible, and a set of tags that are hidden. It answers the same queries as
+ * Fast, as if it were the collection with only the visible items and without
+ * the hidden tags, but without copying any of the item or tag names.
+ *
+ * Items that only have hidden tags are not visible, like Fast::removeTag()
+ * removes items left with no tags.
+ *
+ * The base collection must outlive the view, and must not be modified while
+ * the view is in use.
+ */
+class View
+{
+protected:
+    const Fast* base;
+
+    /// Visible items, sorted by name
+    std::vector<Fast::const_iterator> items;
+
+    /// Tags that are not visible
+    std::set<std::string> excluded;
+
+    View() : base(0) {}
+
+    /// Find a visible item, returning items.end() if it is not visible
+    std::vector<Fast::const_iterator>::const_iterator findItem(const std::string& item) const;
+
+    /// Return true if a tag is not hidden
+    bool visible(const std::string& tag) const { return excluded.find(tag) == excluded.end(); }
+
+    /**
+     * Count the visible items of each visible tag, calling \a fun(tag, card)
+     * for each of them in tag order
+     */
+    template<typename FUN>
+    void countTags(FUN fun) const;
+
+public:
+    /// Create a view showing all the contents of \a base
+    explicit View(const Fast& base);
+
+    /// Return the collection this is a view of
+    const Fast& collection() const { return *base; }
+
+    /// Return the tags hidden by this view
+    const std::set<std::string>& excludedTags() const { return excluded; }
+
+    std::set<std::string> getTagsOfItem(const std::string& item) const;
+    std::set<std::string> getItemsHavingTag(const std::string& tag) const;
+
+    /**
+     * Get the items which are tagged with at least the tags `tags'
+     *
+     * \return
+     *   The items found, or an empty set if no items have that tag
+     */
+    std::set<std::string> getItemsHavingTags(const std::set<std::string>& tags) const;
+
+    bool empty() const { return items.empty(); }
+
+    bool hasItem(const std::string& item) const { return findItem(item) != items.end(); }
+    bool hasTag(const std::string& tag) const;
+    std::set<std::string> getTaggedItems() const;
+    std::set<std::string> getAllTags() const;
+    std::vector<std::string> getAllTagsAsVector() const;
+
+    unsigned int itemCount() const { return items.size(); }
+    unsigned int tagCount() const;
+
+    /// Return the number of visible items that have a tag
+    size_t getCardinality(const std::string& tag) const;
+
+    // tag1 implies tag2 if the itemset of tag1 is a subset of the itemset of
+    // tag2
+    std::set<std::string> getTagsImplying(const std::string& tag) const;
+
+    // Return the items which have the exact tagset 'tags'
+    std::set<std::string> getItemsExactMatch(const std::set<std::string>& tags) const;
+
+    std::string findTagWithMaxCardinality(size_t& card) const;
+
+    /**
+     * Return the view with only those items that have this tag, and with the
+     * given tag hidden.
+     *
+     * This is the view equivalent of Fast::getChildCollection, and does not
+     * copy the collection.
+     */
+    View getChildView(const std::string& tag) const;
+
+    /// Copy the visible contents of the view into a new collection
+    Fast toFast() const;
+};
+
+}
+}
+}
+#endif
@@ -0,0 +1,296 @@
+/*
+ * Benchmarks for loading and querying tag collections
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "debtags.h"
+#include "coll/TextFormat.h"
+#include "coll/view.h"
+#include "coll/expression.h"
+#include "coll/prefixindex.h"
+#include "coll/similarity.h"
+#include "coll/tagstats.h"
+#include "coll/navigator.h"
+#include "coll/cardinalityindex.h"
+#include <algorithm>
+#include <cstdio>
+#include <system_error>
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::debtags;
+
+namespace {
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("textformat_parse", [](Bench& b) {
+            b.run([] {
+                FILE* in = fopen(BENCH_TAGS, "rt");
+                if (!in)
+                    throw std::system_error(errno, std::system_category(), "cannot open " BENCH_TAGS);
+                coll::Fast coll;
+                coll::textformat::parse(in, BENCH_TAGS, coll);
+                fclose(in);
+            });
+            b.bytes(sys::read_file(BENCH_TAGS).size());
+        });
+
+        add_method("items_having_tag", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            vector<string> tags = debtags.getAllTagsAsVector();
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& t : tags)
+                    total += debtags.getItemsHavingTag(t).size();
+            });
+            b.items(tags.size());
+        });
+
+        add_method("items_having_tags", [](Bench& b) {
+            // Query with the first 100 distinct tag sets of the packages
+            // themselves
+            Debtags debtags(BENCH_TAGS);
+            set<set<string>> distinct;
+            for (const auto& i : debtags)
+                if (i.second.size() > 1 && distinct.size() < 100)
+                    distinct.insert(i.second);
+            vector<set<string>> queries(distinct.begin(), distinct.end());
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& q : queries)
+                    total += debtags.getItemsHavingTags(q).size();
+            });
+            b.items(queries.size());
+        });
+
+        add_method("items_exact_match", [](Bench& b) {
+            // Query with all the distinct tag sets of the packages
+            Debtags debtags(BENCH_TAGS);
+            set<set<string>> distinct;
+            for (const auto& i : debtags)
+                distinct.insert(i.second);
+            vector<set<string>> queries(distinct.begin(), distinct.end());
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& q : queries)
+                    total += debtags.getItemsExactMatch(q).size();
+            });
+            b.items(queries.size());
+        });
+
+        add_method("tags_of_item", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            vector<string> items;
+            for (const auto& i : debtags)
+                items.push_back(i.first);
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& i : items)
+                    total += debtags.getTagsOfItem(i).size();
+            });
+            b.items(items.size());
+        });
+
+        add_method("child_collection", [](Bench& b) {
+            // Drill down three levels following the largest tag
+            Debtags debtags(BENCH_TAGS);
+            size_t total = 0;
+            b.run([&] {
+                coll::Fast cur = debtags.getChildCollection(debtags.findTagWithMaxCardinality(total));
+                for (unsigned i = 0; i < 2 && !cur.empty(); ++i)
+                    cur = cur.getChildCollection(cur.findTagWithMaxCardinality(total));
+            });
+        });
+
+        add_method("child_view", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            size_t total = 0;
+            b.run([&] {
+                coll::View cur(debtags);
+                for (unsigned i = 0; i < 3 && !cur.empty(); ++i)
+                    cur = cur.getChildView(cur.findTagWithMaxCardinality(total));
+            });
+        });
+
+        add_method("complete_all_tags", [](Bench& b) {
+            // Complete every prefix of "works-with::image" scanning all tags
+            Debtags debtags(BENCH_TAGS);
+            string word = "works-with::image";
+            size_t total = 0;
+            b.run([&] {
+                for (size_t len = 1; len <= word.size(); ++len)
+                    for (const auto& t : debtags.getAllTags())
+                        if (t.compare(0, len, word, 0, len) == 0)
+                            total += debtags.getItemsHavingTag(t).size();
+            });
+            b.items(word.size());
+        });
+
+        add_method("complete_prefix_index", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            auto index = debtags.prefixIndex();
+            string word = "works-with::image";
+            size_t total = 0;
+            b.run([&] {
+                for (size_t len = 1; len <= word.size(); ++len)
+                    for (const auto& e : index->tags(word.data(), len))
+                        total += e.cardinality;
+            });
+            b.items(word.size());
+        });
+
+        add_method("top_tags_sort", [](Bench& b) {
+            // 20 most frequent tags, sorting all tags by cardinality
+            Debtags debtags(BENCH_TAGS);
+            size_t total = 0;
+            b.run([&] {
+                vector<pair<size_t, string>> tags;
+                for (const auto& t : debtags.getAllTagsAsVector())
+                    tags.push_back(make_pair(debtags.getItemsHavingTag(t).size(), t));
+                partial_sort(tags.begin(), tags.begin() + 20, tags.end(), greater<pair<size_t, string>>());
+                total += tags[0].first;
+            });
+        });
+
+        add_method("top_tags_index", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            debtags.cardinalityIndex();
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& e : debtags.cardinalityIndex()->top(20))
+                    total += e.cardinality;
+            });
+        });
+
+        add_method("navigator", [](Bench& b) {
+            // Drill down three levels following the best split, as in
+            // child_view, and back
+            Debtags debtags(BENCH_TAGS);
+            coll::Navigator nav(debtags);
+            size_t total = 0;
+            b.run([&] {
+                for (unsigned i = 0; i < 3; ++i)
+                {
+                    auto best = nav.rankTags(1);
+                    if (best.empty()) break;
+                    nav.select(best[0].name);
+                    total += nav.size();
+                }
+                while (nav.back())
+                    ;
+            });
+        });
+
+        add_method("similarity_build", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            b.run([&] {
+                coll::SimilarityIndex index(debtags);
+            });
+        });
+
+        add_method("similar", [](Bench& b) {
+            // Top 10 similar packages for one package in 100
+            Debtags debtags(BENCH_TAGS);
+            coll::SimilarityIndex index(debtags);
+            vector<string> items;
+            unsigned n = 0;
+            for (const auto& i : debtags)
+                if (n++ % 100 == 0)
+                    items.push_back(i.first);
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& i : items)
+                    total += index.similar(i, 10).size();
+            });
+            b.items(items.size());
+        });
+
+        add_method("suggest_sets", [](Bench& b) {
+            // Tags going with role::program and interface::x11, intersecting
+            // item sets
+            Debtags debtags(BENCH_TAGS);
+            set<string> query { "role::program", "interface::x11" };
+            size_t total = 0;
+            b.run([&] {
+                set<string> items = debtags.getItemsHavingTags(query);
+                for (const auto& t : debtags.getAllTags())
+                {
+                    set<string> with = debtags.getItemsHavingTag(t);
+                    for (const auto& i : items)
+                        if (with.find(i) != with.end())
+                            ++total;
+                }
+            });
+        });
+
+        add_method("suggest_tagstats", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            coll::TagStats stats(debtags);
+            set<string> query { "role::program", "interface::x11" };
+            size_t total = 0;
+            b.run([&] {
+                total += stats.suggest(query, 20).size();
+            });
+        });
+
+        add_method("tagstats_build", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            b.run([&] {
+                coll::TagStats stats(debtags);
+            });
+        });
+
+        add_method("expression_sets", [](Bench& b) {
+            // role::program && (interface::x11 || interface::commandline) && !use::gameplaying
+            // combining string sets, as done before coll::Expression
+            Debtags debtags(BENCH_TAGS);
+            size_t total = 0;
+            b.run([&] {
+                set<string> res = debtags.getItemsHavingTag("interface::x11");
+                for (const auto& i : debtags.getItemsHavingTag("interface::commandline"))
+                    res.insert(i);
+                set<string> program = debtags.getItemsHavingTag("role::program");
+                set<string> games = debtags.getItemsHavingTag("use::gameplaying");
+                for (auto i = res.begin(); i != res.end(); )
+                    if (program.find(*i) == program.end() || games.find(*i) != games.end())
+                        i = res.erase(i);
+                    else
+                        ++i;
+                total += res.size();
+            });
+        });
+
+        add_method("expression_postings", [](Bench& b) {
+            Debtags debtags(BENCH_TAGS);
+            coll::PostingIndex index(debtags);
+            coll::Expression expr("role::program && (interface::x11 || interface::commandline) && !use::gameplaying");
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& i : expr.match(index))
+                    total += i.size();
+            });
+        });
+    }
+} benchmarks("debtags_debtags");
+
+}
@@ -30,6 +30,13 @@ class Tests : public TestCase
             }
         });
 
+        add_method("load_timings", []() {
+            EnvOverride eo("DEBTAGS_TAGS", testfile);
+            Debtags debtags;
+            wassert(actual(debtags.loadTimings().phases.size()) == 2u);
+            wassert(actual(debtags.loadTimings().get("parse")) > 0);
+        });
+
         add_method("lookup_tags", []() {
             EnvOverride eo("DEBTAGS_TAGS", testfile);
             Debtags debtags;
@@ -57,11 +57,14 @@ Debtags::Debtags(const std::string& pathname)
 void Debtags::load(const std::string& pathname)
 {
     // Read uncompressed data
+    timings::Timer open(m_load_timings, "open");
     FILE* in = fopen(pathname.c_str(), "rt");
     if (!in)
         throw std::system_error(errno, std::system_category(), "cannot open " + pathname);
+    open.stop();
 
     // Read the collection
+    timings::Timer parse(m_load_timings, "parse");
     try {
         coll::textformat::parse(in, pathname, *this);
     } catch (...) {
@@ -69,9 +72,12 @@ void Debtags::load(const std::string& pathname)
         throw;
     }
     fclose(in);
+    parse.stop();
 
     // Read the timestamp
     m_timestamp = sys::timestamp(pathname, 0);
+
+    m_load_timings.report("ept: Debtags load");
 }
 
 string Debtags::pathname()
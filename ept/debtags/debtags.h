@@ -27,6 +27,7 @@
 #define EPT_DEBTAGS_DEBTAGS_H
 
 #include <ept/debtags/coll/fast.h>
+#include <ept/utils/timings.h>
 #include <string>
 
 namespace ept {
@@ -53,6 +54,9 @@ protected:
 	// Last modification timestamp of the index
 	time_t m_timestamp;
 
+	// Time spent loading the database
+	timings::PhaseTimings m_load_timings;
+
     void load(const std::string& pathname);
 
 public:
@@ -71,6 +75,13 @@ public:
 	/// Return true if this data source has data, false if it's empty
 	bool hasData() const { return m_timestamp != 0; }
 
+	/**
+	 * Return the time spent opening and parsing the database.
+	 *
+	 * The timings are also printed to stderr if $EPT_PROFILE_STARTUP is set.
+	 */
+	const timings::PhaseTimings& loadTimings() const { return m_load_timings; }
+
 	coll_type& tagdb() { return *this; }
 	const coll_type& tagdb() const { return *this; }
 
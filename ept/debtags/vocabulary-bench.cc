@@ -0,0 +1,63 @@
+/*
+ * Benchmarks for reading the tag vocabulary
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "ept/bench.h"
+#include "vocabulary.h"
+#include <cstdio>
+#include <system_error>
+
+using namespace std;
+using namespace ept;
+using namespace ept::benchmarks;
+using namespace ept::debtags;
+
+namespace {
+
+class Benchmarks : public BenchmarkCase
+{
+    using BenchmarkCase::BenchmarkCase;
+
+    void register_benchmarks() override
+    {
+        add_method("read", [](Bench& b) {
+            b.run([] {
+                FILE* in = fopen(BENCH_VOCABULARY, "rt");
+                if (!in)
+                    throw std::system_error(errno, std::system_category(), "cannot open " BENCH_VOCABULARY);
+                Vocabulary voc(true);
+                voc.read(in, BENCH_VOCABULARY);
+                fclose(in);
+            });
+            b.bytes(sys::read_file(BENCH_VOCABULARY).size());
+        });
+
+        add_method("tag_data", [](Bench& b) {
+            Vocabulary voc(true);
+            voc.load(BENCH_VOCABULARY);
+            set<string> tags = voc.tags();
+            size_t total = 0;
+            b.run([&] {
+                for (const auto& t : tags)
+                    total += voc.tagData(t)->shortDescription().size();
+            });
+            b.items(tags.size());
+        });
+    }
+} benchmarks("debtags_vocabulary");
+
+}
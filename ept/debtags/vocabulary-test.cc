@@ -2,6 +2,7 @@
 #include "vocabulary.h"
 #include "coll/set.h"
 #include "ept/test.h"
+#include <cstring>
 
 using namespace std;
 using namespace ept::debtags::coll::utils;
@@ -23,6 +24,13 @@ class Tests : public TestCase
             Vocabulary  tags; // this will throw if it failed to load
         });
 
+        add_method("load_timings", []() {
+            EnvOverride eo("DEBTAGS_VOCABULARY", testfile);
+            Vocabulary tags;
+            wassert(actual(tags.loadTimings().phases.size()) == 2u);
+            wassert(actual(tags.loadTimings().total()) > 0);
+        });
+
         add_method("has_facet", []() {
             EnvOverride eo("DEBTAGS_VOCABULARY", testfile);
             Vocabulary tags;
@@ -176,6 +184,36 @@ class Tests : public TestCase
             wassert(actual(t.size()) == 33u);
         });
 
+        add_method("complete", []() {
+            EnvOverride eo("DEBTAGS_VOCABULARY", testfile);
+            Vocabulary voc;
+
+            // Compare with filtering the full lists
+            const char* prefixes[] = { "works-with", "works-with:", "works-with::", "works-with::im", "w", "net", "", "nonsense" };
+            for (const auto& prefix: prefixes)
+            {
+                set<string> expected;
+                for (const auto& t: voc.tags())
+                    if (t.compare(0, strlen(prefix), prefix) == 0)
+                        expected.insert(t);
+                set<string> found;
+                voc.completeTags(prefix, [&](const voc::TagData& t) { found.insert(t.name); });
+                wassert_true(found == expected);
+
+                expected.clear();
+                for (const auto& f: voc.facets())
+                    if (f.compare(0, strlen(prefix), prefix) == 0)
+                        expected.insert(f);
+                found.clear();
+                voc.completeFacets(prefix, [&](const voc::FacetData& f) { found.insert(f.name); });
+                wassert_true(found == expected);
+            }
+
+            set<string> found;
+            voc.completeFacets("works-with", [&](const voc::FacetData& f) { found.insert(f.name); });
+            wassert_true(found == set<string>({ "works-with", "works-with-format" }));
+        });
+
         add_method("empty", []() {
             // If there is no data, Vocabulary should work as an empty vocabulary
             EnvOverride eo("DEBTAGS_VOCABULARY", "./empty/novocabularyhere");
@@ -113,10 +113,13 @@ void Vocabulary::load(const std::string& pathname)
 {
     if (!sys::exists(pathname)) return;
     // Read uncompressed data
+    timings::Timer open(m_load_timings, "open");
     FILE* in = fopen(pathname.c_str(), "rt");
     if (!in)
         throw std::system_error(errno, std::system_category(), "cannot open " + pathname);
+    open.stop();
 
+    timings::Timer parse(m_load_timings, "parse");
     try {
         read(in, pathname);
     } catch (...) {
@@ -124,7 +127,10 @@ void Vocabulary::load(const std::string& pathname)
         throw;
     }
     fclose(in);
+    parse.stop();
     m_timestamp = sys::timestamp(pathname, 0);
+
+    m_load_timings.report("ept: Vocabulary load");
 }
 
 voc::TagData& voc::FacetData::obtainTag(const std::string& name)
@@ -215,6 +221,45 @@ std::set<std::string> Vocabulary::tags(const std::string& facet) const
 	return f->tags();
 }
 
+static bool startswith(const std::string& str, const std::string& prefix)
+{
+	return str.compare(0, prefix.size(), prefix) == 0;
+}
+
+void Vocabulary::completeFacets(const std::string& prefix, std::function<void(const voc::FacetData&)> dest) const
+{
+	for (std::map<std::string, voc::FacetData>::const_iterator i = m_facets.lower_bound(prefix);
+			i != m_facets.end() && startswith(i->first, prefix); ++i)
+		dest(i->second);
+}
+
+static void completeFacetTags(const voc::FacetData& facet, const std::string& prefix, std::function<void(const voc::TagData&)>& dest)
+{
+	for (std::map<std::string, voc::TagData>::const_iterator i = facet.m_tags.lower_bound(prefix);
+			i != facet.m_tags.end() && startswith(i->first, prefix); ++i)
+		dest(i->second);
+}
+
+void Vocabulary::completeTags(const std::string& prefix, std::function<void(const voc::TagData&)> dest) const
+{
+	// Facet names have no colons, so a tag "facet::name" can only start with
+	// prefix if its facet starts with the part of prefix before the first
+	// colon
+	string key = prefix.substr(0, prefix.find(':'));
+	bool legacy_done = false;
+	for (std::map<std::string, voc::FacetData>::const_iterator i = m_facets.lower_bound(key);
+			i != m_facets.end() && startswith(i->first, key); ++i)
+	{
+		completeFacetTags(i->second, prefix, dest);
+		if (i->first == "legacy") legacy_done = true;
+	}
+
+	// Tags without a facet are in the "legacy" facet
+	if (!legacy_done)
+		if (const voc::FacetData* f = facetData("legacy"))
+			completeFacetTags(*f, prefix, dest);
+}
+
 void Vocabulary::read(FILE* input, const std::string& pathname)
 {
 	DebDBParser parser(input, pathname);
@@ -24,11 +24,13 @@
  * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
  */
 
+#include <ept/utils/timings.h>
 #include <string>
 #include <vector>
 #include <set>
 #include <map>
 #include <cstdio>
+#include <functional>
 #include <iosfwd>
 
 namespace ept {
@@ -149,6 +151,9 @@ protected:
 
 	time_t m_timestamp;
 
+	// Time spent loading the vocabulary
+	timings::PhaseTimings m_load_timings;
+
 	// Empty parsed data to return when data is asked for IDs == -1
 	std::map<std::string, std::string> emptyData;
 
@@ -179,6 +184,13 @@ public:
 	/// Return true if this data source has data, false if it's empty
 	bool hasData() const { return m_timestamp != 0; }
 
+	/**
+	 * Return the time spent opening and parsing the vocabulary.
+	 *
+	 * The timings are also printed to stderr if $EPT_PROFILE_STARTUP is set.
+	 */
+	const timings::PhaseTimings& loadTimings() const { return m_load_timings; }
+
 	/**
 	 * Check if there is any data in the merged vocabulary
 	 */
@@ -219,6 +231,21 @@ public:
 	 */
 	std::set<std::string> tags(const std::string& facet) const;
 
+	/**
+	 * Call \a dest for each facet whose name starts with \a prefix, sorted
+	 * by name
+	 */
+	void completeFacets(const std::string& prefix, std::function<void(const voc::FacetData&)> dest) const;
+
+	/**
+	 * Call \a dest for each tag whose full name starts with \a prefix, facet
+	 * by facet.
+	 *
+	 * This looks up the tag maps directly, without building the list of all
+	 * the tags.
+	 */
+	void completeTags(const std::string& prefix, std::function<void(const voc::TagData&)> dest) const;
+
 #if 0
 	/// Get the DerivedTagList with the Equates: expressions read from the vocabulary
 	const DerivedTagList& getEquations() const throw () { return equations; }
@@ -11,6 +11,11 @@
 #include <apt-pkg/progress.h>
 #include <apt-pkg/pkgcachegen.h>
 #include <apt-pkg/init.h>
+#include <ept/debtags/coll/fast.h>
+#include <ept/debtags/coll/TextFormat.h>
+#include <system_error>
+#include <cerrno>
+#include <cstdio>
 #include <cstdlib>
 
 struct EnvOverride
@@ -40,4 +45,19 @@ struct EnvOverride
     }
 };
 
+/// Load the test tag database, or another file in the same format, into \a coll
+inline void load_test_tags(ept::debtags::coll::Fast& coll, const std::string& pathname = TEST_ENV_DIR "debtags/package-tags")
+{
+    FILE* in = fopen(pathname.c_str(), "rt");
+    if (!in)
+        throw std::system_error(errno, std::system_category(), "cannot open " + pathname);
+    try {
+        ept::debtags::coll::textformat::parse(in, pathname, coll);
+    } catch (...) {
+        fclose(in);
+        throw;
+    }
+    fclose(in);
+}
+
 #endif
@@ -0,0 +1,79 @@
+/*
+ * Command line runner for the benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "benchmarks.h"
+#include "sys.h"
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+
+/*
+ * Run the benchmarks, printing a summary to stderr.
+ *
+ * The environment variables BENCH_WHITELIST and BENCH_BLACKLIST select
+ * benchmarks by "case.method" glob, EPT_BENCH_SAMPLES and
+ * EPT_BENCH_SAMPLE_TIME (in seconds) tune the measurements, and
+ * EPT_BENCH_JSON names a file where the results are written as JSON.  Since
+ * run-check runs benchmarks in a temporary directory, EPT_BENCH_JSON should
+ * be an absolute pathname.
+ */
+int main()
+{
+    using namespace ept::benchmarks;
+
+    auto& benchmarks = BenchmarkRegistry::get();
+
+    BenchmarkController controller;
+
+    if (const char* whitelist = getenv("BENCH_WHITELIST"))
+        controller.whitelist = whitelist;
+
+    if (const char* blacklist = getenv("BENCH_BLACKLIST"))
+        controller.blacklist = blacklist;
+
+    if (const char* samples = getenv("EPT_BENCH_SAMPLES"))
+        controller.sample_count = atoi(samples);
+
+    if (const char* sample_time = getenv("EPT_BENCH_SAMPLE_TIME"))
+        controller.sample_time = atof(sample_time);
+
+    auto results = benchmarks.run_benchmarks(controller, stderr);
+
+    unsigned failed = 0;
+    for (const auto& r: results)
+        if (!r.error.empty())
+            ++failed;
+
+    if (const char* pathname = getenv("EPT_BENCH_JSON"))
+    {
+        try {
+            ept::sys::write_file(pathname, to_json(results), 0666);
+        } catch (std::exception& e) {
+            fprintf(stderr, "cannot write %s: %s\n", pathname, e.what());
+            return 1;
+        }
+    }
+
+    if (failed)
+    {
+        fprintf(stderr, "\n%u/%zu benchmarks failed\n", failed, results.size());
+        return 1;
+    }
+    fprintf(stderr, "%zu benchmarks run\n", results.size());
+    return 0;
+}
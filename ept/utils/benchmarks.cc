@@ -0,0 +1,236 @@
+/*
+ * Utility functions for the benchmarks
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "benchmarks.h"
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <exception>
+#include <fnmatch.h>
+
+using namespace std;
+
+namespace ept {
+namespace benchmarks {
+
+double BenchmarkResult::min() const
+{
+    if (samples.empty()) return 0;
+    return *min_element(samples.begin(), samples.end());
+}
+
+double BenchmarkResult::median() const
+{
+    if (samples.empty()) return 0;
+    vector<double> sorted(samples);
+    sort(sorted.begin(), sorted.end());
+    size_t mid = sorted.size() / 2;
+    if (sorted.size() % 2)
+        return sorted[mid];
+    return (sorted[mid - 1] + sorted[mid]) / 2;
+}
+
+double BenchmarkResult::mean() const
+{
+    if (samples.empty()) return 0;
+    double sum = 0;
+    for (auto s : samples)
+        sum += s;
+    return sum / samples.size();
+}
+
+namespace {
+
+// Escape a string for use in JSON
+string json_string(const string& s)
+{
+    string res("\"");
+    for (char c : s)
+    {
+        switch (c)
+        {
+            case '"': res += "\\\""; break;
+            case '\\': res += "\\\\"; break;
+            case '\n': res += "\\n"; break;
+            case '\t': res += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20)
+                {
+                    char buf[8];
+                    snprintf(buf, 8, "\\u%04x", c);
+                    res += buf;
+                } else
+                    res += c;
+        }
+    }
+    res += "\"";
+    return res;
+}
+
+}
+
+std::string BenchmarkResult::to_json() const
+{
+    stringstream out;
+    out.precision(6);
+    out << fixed;
+    out << "{\"case\": " << json_string(benchmark_case)
+        << ", \"method\": " << json_string(benchmark_method);
+    if (!error.empty())
+    {
+        out << ", \"error\": " << json_string(error) << "}";
+        return out.str();
+    }
+    double median_ns = median();
+    out << ", \"iterations\": " << iterations
+        << ", \"samples\": " << samples.size()
+        << ", \"min_ns\": " << min()
+        << ", \"median_ns\": " << median_ns
+        << ", \"mean_ns\": " << mean();
+    if (bytes && median_ns > 0)
+        out << ", \"bytes\": " << bytes
+            << ", \"bytes_per_second\": " << bytes * 1e9 / median_ns;
+    if (items && median_ns > 0)
+        out << ", \"items\": " << items
+            << ", \"items_per_second\": " << items * 1e9 / median_ns;
+    out << "}";
+    return out.str();
+}
+
+void Bench::run(std::function<void()> fun)
+{
+    typedef chrono::steady_clock clock;
+
+    // Warm up caches and lazily initialised data
+    fun();
+
+    // Find how many calls make a sample long enough
+    unsigned iterations = 1;
+    while (true)
+    {
+        auto start = clock::now();
+        for (unsigned i = 0; i < iterations; ++i)
+            fun();
+        chrono::duration<double> elapsed = clock::now() - start;
+        if (elapsed.count() >= sample_time || iterations >= (1u << 30))
+            break;
+        iterations *= 2;
+    }
+
+    result.iterations = iterations;
+    result.samples.clear();
+    for (unsigned s = 0; s < sample_count; ++s)
+    {
+        auto start = clock::now();
+        for (unsigned i = 0; i < iterations; ++i)
+            fun();
+        chrono::duration<double, nano> elapsed = clock::now() - start;
+        result.samples.push_back(elapsed.count() / iterations);
+    }
+}
+
+BenchmarkCase::BenchmarkCase(const std::string& name)
+    : name(name)
+{
+    BenchmarkRegistry::get().register_benchmark_case(*this);
+}
+
+bool BenchmarkController::should_run(const std::string& fullname) const
+{
+    if (!whitelist.empty() && fnmatch(whitelist.c_str(), fullname.c_str(), 0) == FNM_NOMATCH)
+        return false;
+    if (!blacklist.empty() && fnmatch(blacklist.c_str(), fullname.c_str(), 0) != FNM_NOMATCH)
+        return false;
+    return true;
+}
+
+BenchmarkRegistry& BenchmarkRegistry::get()
+{
+    static BenchmarkRegistry* instance = 0;
+    if (!instance)
+        instance = new BenchmarkRegistry();
+    return *instance;
+}
+
+void BenchmarkRegistry::register_benchmark_case(BenchmarkCase& benchmark_case)
+{
+    entries.emplace_back(&benchmark_case);
+}
+
+std::vector<BenchmarkResult> BenchmarkRegistry::run_benchmarks(const BenchmarkController& controller, FILE* out)
+{
+    // Run in a stable order, independent of static initialisation order
+    vector<BenchmarkCase*> cases(entries);
+    sort(cases.begin(), cases.end(), [](const BenchmarkCase* a, const BenchmarkCase* b) { return a->name < b->name; });
+
+    std::vector<BenchmarkResult> res;
+    for (auto& c: cases)
+    {
+        c->register_benchmarks();
+        for (auto& m: c->methods)
+        {
+            if (!controller.should_run(c->name + "." + m.name))
+                continue;
+
+            BenchmarkResult r;
+            r.benchmark_case = c->name;
+            r.benchmark_method = m.name;
+            Bench bench(r, controller.sample_time, controller.sample_count);
+            try {
+                m.bench_function(bench);
+            } catch (std::exception& e) {
+                r.error = e.what();
+            }
+
+            if (out)
+            {
+                if (!r.error.empty())
+                    fprintf(out, "%s.%s: failed: %s\n", c->name.c_str(), m.name.c_str(), r.error.c_str());
+                else
+                {
+                    fprintf(out, "%s.%s: %.1fns median, %.1fns min", c->name.c_str(), m.name.c_str(), r.median(), r.min());
+                    if (r.bytes && r.median() > 0)
+                        fprintf(out, ", %.1fMiB/s", r.bytes * 1e9 / r.median() / (1024 * 1024));
+                    if (r.items && r.median() > 0)
+                        fprintf(out, ", %.0f items/s", r.items * 1e9 / r.median());
+                    fprintf(out, "\n");
+                }
+            }
+            res.emplace_back(move(r));
+        }
+    }
+    return res;
+}
+
+std::string to_json(const std::vector<BenchmarkResult>& results)
+{
+    string res("{\"benchmarks\": [\n");
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        res += "  ";
+        res += results[i].to_json();
+        if (i + 1 < results.size())
+            res += ",";
+        res += "\n";
+    }
+    res += "]}\n";
+    return res;
+}
+
+}
+}
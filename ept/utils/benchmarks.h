@@ -0,0 +1,172 @@
+#ifndef EPT_BENCHMARKS_H
+#define EPT_BENCHMARKS_H
+
+/**
+ * @brief Utility functions for the benchmarks
+ *
+ * Benchmarks are organised like the unit tests: a BenchmarkCase groups
+ * several benchmark methods and registers itself with the BenchmarkRegistry
+ * singleton, and bench-main runs all of them.
+ */
+
+#include <string>
+#include <functional>
+#include <vector>
+#include <cstdio>
+
+namespace ept {
+namespace benchmarks {
+
+struct BenchmarkCase;
+
+/// Timing results of a benchmark method
+struct BenchmarkResult
+{
+    /// Name of the benchmark case
+    std::string benchmark_case;
+
+    /// Name of the benchmark method
+    std::string benchmark_method;
+
+    /// Number of calls of the measured function in each sample
+    unsigned iterations = 0;
+
+    /// Time per call of each sample, in nanoseconds
+    std::vector<double> samples;
+
+    /// Bytes processed in each call, if set by the benchmark
+    size_t bytes = 0;
+
+    /// Items processed in each call, if set by the benchmark
+    size_t items = 0;
+
+    /// Error message, if the benchmark failed
+    std::string error;
+
+    double min() const;
+    double median() const;
+    double mean() const;
+
+    /// Format the result as a JSON object
+    std::string to_json() const;
+};
+
+/**
+ * Measure a function.
+ *
+ * Benchmark methods get a Bench, do their setup, and then call run() with the
+ * function to time.
+ */
+struct Bench
+{
+    BenchmarkResult& result;
+
+    /// Minimum duration of a sample, in seconds
+    double sample_time;
+
+    /// Number of samples to take
+    unsigned sample_count;
+
+    Bench(BenchmarkResult& result, double sample_time, unsigned sample_count)
+        : result(result), sample_time(sample_time), sample_count(sample_count) {}
+
+    /**
+     * Time fun: after a warm up call, the number of calls per sample is
+     * doubled until a sample lasts at least sample_time, then sample_count
+     * samples are taken.
+     */
+    void run(std::function<void()> fun);
+
+    /// Set the number of bytes processed by each call, to compute throughput
+    void bytes(size_t count) { result.bytes = count; }
+
+    /// Set the number of items processed by each call, to compute throughput
+    void items(size_t count) { result.items = count; }
+};
+
+/// Benchmark method information
+struct BenchmarkMethod
+{
+    /// Name of the benchmark method
+    std::string name;
+
+    /// Main body of the benchmark method
+    std::function<void(Bench&)> bench_function;
+
+    BenchmarkMethod(const std::string& name, std::function<void(Bench&)> bench_function)
+        : name(name), bench_function(bench_function) {}
+};
+
+/**
+ * Benchmark case collecting several benchmark methods, and self-registering
+ * with the singleton instance of BenchmarkRegistry.
+ */
+struct BenchmarkCase
+{
+    /// Name of the benchmark case
+    std::string name;
+
+    /// All registered benchmark methods
+    std::vector<BenchmarkMethod> methods;
+
+    BenchmarkCase(const std::string& name);
+    virtual ~BenchmarkCase() {}
+
+    /**
+     * This will be called before running the benchmark case, to populate it
+     * with its benchmark methods.
+     */
+    virtual void register_benchmarks() = 0;
+
+    /// Register a new benchmark method
+    void add_method(const std::string& name, std::function<void(Bench&)> bench_function)
+    {
+        methods.emplace_back(name, bench_function);
+    }
+};
+
+/// Select and configure the benchmarks to run
+struct BenchmarkController
+{
+    /// Any method not matching this glob expression will not be run
+    std::string whitelist;
+
+    /// Any method matching this glob expression will not be run
+    std::string blacklist;
+
+    /// Minimum duration of a sample, in seconds
+    double sample_time = 0.05;
+
+    /// Number of samples to take
+    unsigned sample_count = 10;
+
+    /// Return true if the method "case.method" should be run
+    bool should_run(const std::string& fullname) const;
+};
+
+/// Collect and run all benchmark cases
+struct BenchmarkRegistry
+{
+    /// All known benchmark cases
+    std::vector<BenchmarkCase*> entries;
+
+    /// Register a new benchmark case
+    void register_benchmark_case(BenchmarkCase& benchmark_case);
+
+    /**
+     * Run all the registered benchmarks, printing a line for each one to
+     * out if it is not null.
+     */
+    std::vector<BenchmarkResult> run_benchmarks(const BenchmarkController& controller, FILE* out);
+
+    /// Get the singleton instance of BenchmarkRegistry
+    static BenchmarkRegistry& get();
+};
+
+/// Format a list of results as a JSON document
+std::string to_json(const std::vector<BenchmarkResult>& results);
+
+}
+}
+
+#endif
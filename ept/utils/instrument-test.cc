@@ -0,0 +1,71 @@
+#include "ept/test.h"
+#include "instrument.h"
+#include <thread>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+
+namespace {
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("buckets", []() {
+            for (uint64_t v : { 0, 1, 7, 8, 9, 15, 16, 17, 1000, 123456789 })
+            {
+                unsigned b = instrument::bucket(v);
+                wassert(actual(instrument::bucketLowerBound(b)) <= v);
+                wassert(actual(instrument::bucketLowerBound(b + 1)) > v);
+            }
+            wassert(actual(instrument::bucket(UINT64_MAX)) < instrument::histogram_buckets);
+        });
+
+        add_method("disabled", []() {
+            instrument::setEnabled(false);
+            instrument::reset();
+            instrument::count(instrument::FindPkg);
+            instrument::record(instrument::RecordReadLatency, 100);
+            instrument::Snapshot s = instrument::snapshot();
+            wassert(actual(s.counters[instrument::FindPkg]) == 0u);
+            wassert(actual(s.histograms[instrument::RecordReadLatency].count) == 0u);
+        });
+
+        add_method("threads", []() {
+            instrument::setEnabled(true);
+            instrument::reset();
+            vector<std::thread> threads;
+            for (unsigned t = 0; t < 4; ++t)
+                threads.emplace_back([] {
+                    for (unsigned i = 1; i <= 100; ++i)
+                    {
+                        instrument::count(instrument::FindPkg);
+                        instrument::record(instrument::RecordReadLatency, i * 1000);
+                    }
+                });
+            for (auto& t : threads)
+                t.join();
+            instrument::count(instrument::FindPkg, 10);
+
+            instrument::Snapshot s = instrument::snapshot();
+            instrument::setEnabled(false);
+            wassert(actual(s.counters[instrument::FindPkg]) == 410u);
+            const instrument::HistogramSnapshot& h = s.histograms[instrument::RecordReadLatency];
+            wassert(actual(h.count) == 400u);
+            wassert(actual(h.min) == 1000u);
+            wassert(actual(h.max) == 100000u);
+            // Buckets are precise within 12.5%
+            wassert(actual(h.percentile(0.5)) >= 50000u * 7 / 8);
+            wassert(actual(h.percentile(0.5)) <= 51000u);
+            wassert(actual(s.to_json().find("\"find_pkg\": 410")) != string::npos);
+
+            instrument::reset();
+            wassert(actual(instrument::snapshot().counters[instrument::FindPkg]) == 0u);
+        });
+    }
+} tests("utils_instrument");
+
+}
@@ -0,0 +1,291 @@
+/*
+ * Low overhead counters and latency histograms for hot paths
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "instrument.h"
+#include <mutex>
+#include <set>
+#include <sstream>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+namespace ept {
+namespace instrument {
+
+std::atomic<bool> enabled_flag(getenv("EPT_INSTRUMENT") != nullptr);
+
+namespace {
+
+struct ThreadHistogram
+{
+    std::atomic<uint64_t> count;
+    std::atomic<uint64_t> sum;
+    std::atomic<uint64_t> min;
+    std::atomic<uint64_t> max;
+    std::atomic<uint64_t> buckets[histogram_buckets];
+
+    ThreadHistogram() { reset(); }
+
+    void reset()
+    {
+        count.store(0, memory_order_relaxed);
+        sum.store(0, memory_order_relaxed);
+        min.store(UINT64_MAX, memory_order_relaxed);
+        max.store(0, memory_order_relaxed);
+        for (auto& b : buckets)
+            b.store(0, memory_order_relaxed);
+    }
+
+    // Only called by the owning thread, so there are no concurrent writers
+    void add(uint64_t value)
+    {
+        count.store(count.load(memory_order_relaxed) + 1, memory_order_relaxed);
+        sum.store(sum.load(memory_order_relaxed) + value, memory_order_relaxed);
+        if (value < min.load(memory_order_relaxed))
+            min.store(value, memory_order_relaxed);
+        if (value > max.load(memory_order_relaxed))
+            max.store(value, memory_order_relaxed);
+        auto& b = buckets[bucket(value)];
+        b.store(b.load(memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+
+    void merge_into(HistogramSnapshot& out) const
+    {
+        uint64_t c = count.load(memory_order_relaxed);
+        if (!c) return;
+        uint64_t mn = min.load(memory_order_relaxed);
+        uint64_t mx = max.load(memory_order_relaxed);
+        if (!out.count || mn < out.min) out.min = mn;
+        if (mx > out.max) out.max = mx;
+        out.count += c;
+        out.sum += sum.load(memory_order_relaxed);
+        for (unsigned i = 0; i < histogram_buckets; ++i)
+            out.buckets[i] += buckets[i].load(memory_order_relaxed);
+    }
+};
+
+/**
+ * Counters and histograms of a thread.
+ *
+ * Values are atomics only so that snapshot() can read them while the owning
+ * thread updates them: since there is only one writer, updates are plain
+ * relaxed loads and stores.
+ */
+struct ThreadData
+{
+    std::atomic<uint64_t> counters[counter_count];
+    ThreadHistogram histograms[histogram_count];
+
+    ThreadData() { reset(); }
+
+    void reset()
+    {
+        for (auto& c : counters)
+            c.store(0, memory_order_relaxed);
+        for (auto& h : histograms)
+            h.reset();
+    }
+
+    void merge_into(Snapshot& out) const
+    {
+        for (unsigned i = 0; i < counter_count; ++i)
+            out.counters[i] += counters[i].load(memory_order_relaxed);
+        for (unsigned i = 0; i < histogram_count; ++i)
+            histograms[i].merge_into(out.histograms[i]);
+    }
+};
+
+struct Registry
+{
+    std::mutex mutex;
+    // Data of the running threads
+    std::set<ThreadData*> threads;
+    // Values accumulated by the threads that have exited
+    Snapshot retired;
+};
+
+// Never destroyed, since threads can exit after static destructors have run
+Registry& registry()
+{
+    static Registry* res = new Registry;
+    return *res;
+}
+
+// Registers the data of a thread on first use, and retires it on exit
+struct ThreadSlot
+{
+    ThreadData data;
+
+    ThreadSlot()
+    {
+        Registry& r = registry();
+        lock_guard<mutex> lock(r.mutex);
+        r.threads.insert(&data);
+    }
+
+    ~ThreadSlot()
+    {
+        Registry& r = registry();
+        lock_guard<mutex> lock(r.mutex);
+        data.merge_into(r.retired);
+        r.threads.erase(&data);
+    }
+};
+
+ThreadData& thread_data()
+{
+    static thread_local ThreadSlot slot;
+    return slot.data;
+}
+
+}
+
+unsigned bucket(uint64_t value)
+{
+    if (value < 8) return value;
+    unsigned e = 63 - __builtin_clzll(value);
+    unsigned sub = (value >> (e - 3)) & 7;
+    return (e - 2) * 8 + sub;
+}
+
+uint64_t bucketLowerBound(unsigned bucket)
+{
+    if (bucket < 8) return bucket;
+    unsigned e = bucket / 8 + 2;
+    uint64_t sub = bucket % 8;
+    return (8 + sub) << (e - 3);
+}
+
+void setEnabled(bool enabled)
+{
+    enabled_flag.store(enabled, memory_order_relaxed);
+}
+
+void addCount(Counter counter, uint64_t amount)
+{
+    auto& c = thread_data().counters[counter];
+    c.store(c.load(memory_order_relaxed) + amount, memory_order_relaxed);
+}
+
+void addValue(Histogram histogram, uint64_t value)
+{
+    thread_data().histograms[histogram].add(value);
+}
+
+uint64_t HistogramSnapshot::percentile(double fraction) const
+{
+    if (!count) return 0;
+    uint64_t target = fraction * count;
+    uint64_t seen = 0;
+    for (unsigned i = 0; i < histogram_buckets; ++i)
+    {
+        seen += buckets[i];
+        if (seen > target)
+            return std::max(std::min(bucketLowerBound(i), max), min);
+    }
+    return max;
+}
+
+const char* Snapshot::name(Counter counter)
+{
+    switch (counter)
+    {
+        case FindPkg: return "find_pkg";
+        case GetCandidateVer: return "get_candidate_ver";
+        case RecordSeek: return "record_seek";
+        case RecordSequentialRead: return "record_sequential_read";
+        case RecordBytesRead: return "record_bytes_read";
+        case RecordParse: return "record_parse";
+        case RecordParseBytes: return "record_parse_bytes";
+        case FastIntersection: return "fast_intersection";
+        case TagParseBytes: return "tag_parse_bytes";
+    }
+    return "unknown";
+}
+
+const char* Snapshot::name(Histogram histogram)
+{
+    switch (histogram)
+    {
+        case RecordReadLatency: return "record_read_ns";
+        case RecordParseLatency: return "record_parse_ns";
+        case FastQueryLatency: return "fast_query_ns";
+    }
+    return "unknown";
+}
+
+std::string Snapshot::to_json() const
+{
+    stringstream out;
+    out << "{\"counters\": {";
+    for (unsigned i = 0; i < counter_count; ++i)
+        out << (i ? ", " : "") << "\"" << name((Counter)i) << "\": " << counters[i];
+    out << "}, \"histograms\": {";
+    for (unsigned i = 0; i < histogram_count; ++i)
+    {
+        const HistogramSnapshot& h = histograms[i];
+        out << (i ? ", " : "") << "\"" << name((Histogram)i) << "\": {"
+            << "\"count\": " << h.count
+            << ", \"sum\": " << h.sum
+            << ", \"min\": " << h.min
+            << ", \"max\": " << h.max
+            << ", \"p50\": " << h.percentile(0.5)
+            << ", \"p90\": " << h.percentile(0.9)
+            << ", \"p99\": " << h.percentile(0.99)
+            << "}";
+    }
+    out << "}}";
+    return out.str();
+}
+
+void Snapshot::print(FILE* out) const
+{
+    for (unsigned i = 0; i < counter_count; ++i)
+        fprintf(out, "%s: %llu\n", name((Counter)i), (unsigned long long)counters[i]);
+    for (unsigned i = 0; i < histogram_count; ++i)
+    {
+        const HistogramSnapshot& h = histograms[i];
+        fprintf(out, "%s: count %llu mean %.0f p50 %llu p90 %llu p99 %llu max %llu\n",
+                name((Histogram)i), (unsigned long long)h.count, h.mean(),
+                (unsigned long long)h.percentile(0.5), (unsigned long long)h.percentile(0.9),
+                (unsigned long long)h.percentile(0.99), (unsigned long long)h.max);
+    }
+}
+
+Snapshot snapshot()
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.mutex);
+    Snapshot res = r.retired;
+    for (const auto& t : r.threads)
+        t->merge_into(res);
+    return res;
+}
+
+void reset()
+{
+    Registry& r = registry();
+    lock_guard<mutex> lock(r.mutex);
+    r.retired = Snapshot();
+    for (auto& t : r.threads)
+        t->reset();
+}
+
+}
+}
@@ -0,0 +1,179 @@
+#ifndef EPT_INSTRUMENT_H
+#define EPT_INSTRUMENT_H
+
+/**
+ * @brief Low overhead counters and latency histograms for hot paths
+ *
+ * Instrumentation is always compiled in, and disabled by default: when
+ * disabled, each instrumentation point costs a relaxed atomic load and a
+ * branch.  It can be enabled with setEnabled(), or by setting
+ * $EPT_INSTRUMENT in the environment.
+ *
+ * Each thread updates its own counters and histograms, without locking;
+ * snapshot() adds up the values of all threads, including the ones that
+ * have exited.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdio>
+
+namespace ept {
+namespace instrument {
+
+/// Operations that are counted
+enum Counter {
+    /// Package lookups by name
+    FindPkg,
+    /// Candidate version lookups, including the ones done to build indices
+    GetCandidateVer,
+    /// Record buffer refills that needed a seek
+    RecordSeek,
+    /// Record buffer refills that continued the previous read
+    RecordSequentialRead,
+    /// Bytes read by record buffer refills
+    RecordBytesRead,
+    /// Records scanned by RecordParser
+    RecordParse,
+    /// Bytes scanned by RecordParser
+    RecordParseBytes,
+    /// Set intersections computed by coll::Fast queries
+    FastIntersection,
+    /// Bytes of tag data parsed by coll::textformat
+    TagParseBytes,
+};
+static const unsigned counter_count = TagParseBytes + 1;
+
+/// Operations whose latency is measured, in nanoseconds
+enum Histogram {
+    /// Time spent in record buffer refills
+    RecordReadLatency,
+    /// Time spent scanning a record in RecordParser
+    RecordParseLatency,
+    /// Time spent answering a coll::Fast query on many tags
+    FastQueryLatency,
+};
+static const unsigned histogram_count = FastQueryLatency + 1;
+
+/**
+ * Number of buckets in a histogram.
+ *
+ * Values below 8 have a bucket each; above that, each power of two is split
+ * in 8 buckets, so that a value is known within 12.5%.
+ */
+static const unsigned histogram_buckets = 62 * 8;
+
+/// Return the histogram bucket for a value
+unsigned bucket(uint64_t value);
+
+/// Return the smallest value that falls in a histogram bucket
+uint64_t bucketLowerBound(unsigned bucket);
+
+/// Whether instrumentation is enabled
+extern std::atomic<bool> enabled_flag;
+
+/// Check if instrumentation is enabled
+inline bool enabled() { return enabled_flag.load(std::memory_order_relaxed); }
+
+/// Enable or disable instrumentation at runtime
+void setEnabled(bool enabled);
+
+/// Add to a counter, implementation of count()
+void addCount(Counter counter, uint64_t amount);
+
+/// Add a value to a histogram, implementation of record()
+void addValue(Histogram histogram, uint64_t value);
+
+/// Add to a counter, if instrumentation is enabled
+inline void count(Counter counter, uint64_t amount=1)
+{
+    if (enabled()) addCount(counter, amount);
+}
+
+/// Add a latency in nanoseconds to a histogram, if instrumentation is enabled
+inline void record(Histogram histogram, uint64_t nanoseconds)
+{
+    if (enabled()) addValue(histogram, nanoseconds);
+}
+
+/**
+ * Record in a histogram the time from construction to destruction.
+ *
+ * The clock is not read at all if instrumentation is disabled when the
+ * object is created.
+ */
+class Latency
+{
+    Histogram histogram;
+    bool active;
+    std::chrono::steady_clock::time_point start;
+
+public:
+    explicit Latency(Histogram histogram)
+        : histogram(histogram), active(enabled())
+    {
+        if (active) start = std::chrono::steady_clock::now();
+    }
+    Latency(const Latency&) = delete;
+    Latency& operator=(const Latency&) = delete;
+    ~Latency()
+    {
+        if (!active) return;
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        addValue(histogram, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+};
+
+/// Summed up contents of a histogram
+struct HistogramSnapshot
+{
+    uint64_t count = 0;
+    uint64_t sum = 0;
+    uint64_t min = 0;
+    uint64_t max = 0;
+    std::vector<uint64_t> buckets;
+
+    HistogramSnapshot() : buckets(histogram_buckets, 0) {}
+
+    /// Return the average value, or 0 if the histogram is empty
+    double mean() const { return count ? (double)sum / count : 0; }
+
+    /**
+     * Return an approximation of the value below which falls the given
+     * fraction (between 0 and 1) of the values.
+     */
+    uint64_t percentile(double fraction) const;
+};
+
+/// Values of all counters and histograms at a given time
+struct Snapshot
+{
+    uint64_t counters[counter_count] = {};
+    HistogramSnapshot histograms[histogram_count];
+
+    /// Return the name of a counter
+    static const char* name(Counter counter);
+
+    /// Return the name of a histogram
+    static const char* name(Histogram histogram);
+
+    /// Format the snapshot as a JSON object
+    std::string to_json() const;
+
+    /// Print the snapshot in human readable form
+    void print(FILE* out) const;
+};
+
+/// Return the current values of all counters and histograms
+Snapshot snapshot();
+
+/// Reset all counters and histograms to zero
+void reset();
+
+}
+}
+
+#endif
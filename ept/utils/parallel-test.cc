@@ -0,0 +1,76 @@
+#include "ept/test.h"
+#include "parallel.h"
+#include <vector>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+
+namespace {
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("partition", []() {
+            // Small inputs use a single worker
+            parallel::Partition small(100, 8, 1024);
+            wassert(actual(small.workers) == 1u);
+            wassert(actual(small.begin(0)) == 0u);
+            wassert(actual(small.end(0)) == 100u);
+
+            parallel::Partition empty(0, 8, 1024);
+            wassert(actual(empty.workers) == 1u);
+            wassert(actual(empty.end(0)) == 0u);
+
+            // Chunks cover all items, in order
+            parallel::Partition part(10000, 4, 1024);
+            wassert(actual(part.workers) == 4u);
+            wassert(actual(part.begin(0)) == 0u);
+            for (size_t w = 1; w < part.workers; ++w)
+                wassert(actual(part.begin(w)) == part.end(w - 1));
+            wassert(actual(part.end(part.workers - 1)) == 10000u);
+
+            // 0 threads means as many as the cores
+            wassert(actual(parallel::Partition(1000000, 0, 1).workers) >= 1u);
+        });
+
+        add_method("run", []() {
+            parallel::Partition part(10000, 3, 100);
+            vector<unsigned> seen(10000, 0);
+            vector<size_t> items(part.workers, 0);
+            parallel::run(part, [&](size_t w, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i)
+                    ++seen[i];
+                items[w] = end - begin;
+            });
+            for (const auto& s: seen)
+                wassert(actual(s) == 1u);
+            size_t total = 0;
+            for (const auto& i: items)
+                total += i;
+            wassert(actual(total) == 10000u);
+        });
+
+        add_method("run_exception", []() {
+            // Exceptions in other workers than the calling thread are
+            // rethrown after all workers finished
+            parallel::Partition part(10000, 3, 100);
+            vector<unsigned> done(part.workers, 0);
+            auto run = [&]() {
+                parallel::run(part, [&](size_t w, size_t begin, size_t end) {
+                    if (w == 2)
+                        throw std::runtime_error("worker 2 failed");
+                    done[w] = 1;
+                });
+            };
+            wassert(actual_function(run).throws("worker 2 failed"));
+            wassert(actual(done[0]) == 1u);
+            wassert(actual(done[1]) == 1u);
+        });
+    }
+} tests("utils_parallel");
+
+}
@@ -0,0 +1,75 @@
+/*
+ * Split work on ranges of items across threads
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "parallel.h"
+#include <algorithm>
+#include <exception>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+namespace ept {
+namespace parallel {
+
+Partition::Partition(size_t size, unsigned threads, size_t min_chunk)
+    : size(size)
+{
+    if (threads == 0)
+        threads = std::thread::hardware_concurrency();
+    if (threads == 0)
+        threads = 1;
+    if (min_chunk == 0)
+        min_chunk = 1;
+    workers = max<size_t>(1, min<size_t>(threads, (size + min_chunk - 1) / min_chunk));
+    chunk = max<size_t>(1, (size + workers - 1) / workers);
+}
+
+void run(const Partition& part, std::function<void(size_t w, size_t begin, size_t end)> fun)
+{
+    // Exception raised by each worker, if any
+    vector<exception_ptr> errors(part.workers);
+    auto work = [&](size_t w) {
+        try {
+            fun(w, part.begin(w), part.end(w));
+        } catch (...) {
+            errors[w] = current_exception();
+        }
+    };
+
+    vector<std::thread> pool;
+    try {
+        for (size_t w = 1; w < part.workers; ++w)
+            pool.emplace_back(work, w);
+    } catch (...) {
+        // Do not destroy joinable threads
+        for (auto& t: pool)
+            t.join();
+        throw;
+    }
+    work(0);
+    for (auto& t: pool)
+        t.join();
+
+    for (const auto& e: errors)
+        if (e)
+            rethrow_exception(e);
+}
+
+}
+}
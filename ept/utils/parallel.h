@@ -0,0 +1,54 @@
+#ifndef EPT_PARALLEL_H
+#define EPT_PARALLEL_H
+
+/**
+ * @brief Split work on ranges of items across threads
+ */
+
+#include <functional>
+#include <cstddef>
+
+namespace ept {
+namespace parallel {
+
+/**
+ * Split the items from 0 to size in consecutive chunks, one for each worker
+ * thread.
+ *
+ * Only as many workers are used as there are chunks of at least min_chunk
+ * items, so that small inputs are handled in the calling thread alone.
+ */
+struct Partition
+{
+    size_t size;
+    size_t workers;
+    size_t chunk;
+
+    /**
+     * @param threads
+     *   Maximum number of workers, or 0 to use as many as the available
+     *   cores
+     */
+    Partition(size_t size, unsigned threads, size_t min_chunk);
+
+    /// First item of the chunk of worker w
+    size_t begin(size_t w) const { return w * chunk < size ? w * chunk : size; }
+
+    /// End of the chunk of worker w
+    size_t end(size_t w) const { return begin(w + 1); }
+};
+
+/**
+ * Call fun(w, begin, end) for the chunk of each worker w of the partition,
+ * in parallel, and wait for all of them.
+ *
+ * Worker 0 runs in the calling thread. If any worker throws an exception,
+ * the one of the lowest numbered worker is rethrown after all of them have
+ * finished.
+ */
+void run(const Partition& part, std::function<void(size_t w, size_t begin, size_t end)> fun);
+
+}
+}
+
+#endif
@@ -212,6 +212,7 @@ MMap::~MMap()
 
 void MMap::munmap()
 {
+    if (addr == MAP_FAILED) return;
     if (::munmap(addr, length) == -1)
         throw std::system_error(errno, std::system_category(), "cannot unmap memory");
     addr = MAP_FAILED;
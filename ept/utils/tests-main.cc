@@ -3,6 +3,9 @@
 #include <cstdlib>
 #include <cstring>
 #include <exception>
+#include <algorithm>
+#include <string>
+#include <vector>
 
 void signal_to_exception(int)
 {
@@ -74,7 +77,36 @@ int main(int argc,const char* argv[])
     if (const char* blacklist = getenv("TEST_BLACKLIST"))
         controller.blacklist = blacklist;
 
-  auto all_results = tests.run_tests(controller);
+    // Number of test cases to run in parallel, from TEST_JOBS or -j N
+    unsigned jobs = 1;
+    if (const char* env_jobs = getenv("TEST_JOBS"))
+        jobs = strtoul(env_jobs, 0, 10);
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+            jobs = strtoul(argv[++i], 0, 10);
+        else if (strncmp(argv[i], "-j", 2) == 0)
+            jobs = strtoul(argv[i] + 2, 0, 10);
+    }
+
+  auto all_results = tests.run_tests(controller, jobs);
+
+  // Print the time taken by each test method, slowest first
+  if (getenv("TEST_TIMINGS"))
+  {
+      std::vector<const TestMethodResult*> timed;
+      for (const auto& tc_res: all_results)
+          for (const auto& tm_res: tc_res.methods)
+              if (!tm_res.skipped)
+                  timed.push_back(&tm_res);
+      std::stable_sort(timed.begin(), timed.end(), [](const TestMethodResult* a, const TestMethodResult* b) {
+          return a->elapsed > b->elapsed;
+      });
+      fprintf(stdout, "\nTest timings:\n");
+      for (const auto& tm_res: timed)
+          fprintf(stdout, "%9.3fs %s.%s\n", tm_res->elapsed, tm_res->test_case.c_str(), tm_res->test_method.c_str());
+      fflush(stdout);
+  }
 
   unsigned methods_ok = 0;
   unsigned methods_failed = 0;
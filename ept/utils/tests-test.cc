@@ -0,0 +1,158 @@
+#include "ept/test.h"
+#include <cstdlib>
+#include <unistd.h>
+
+using namespace std;
+using namespace ept;
+using namespace ept::tests;
+
+namespace {
+
+/// Test case with a single method, registered in a private registry
+struct OneMethod : public TestCase
+{
+    std::function<void()> body;
+
+    OneMethod(TestRegistry& registry, const std::string& name, std::function<void()> body)
+        : TestCase(registry, name), body(body) {}
+
+    void register_tests() override
+    {
+        add_method("method", body);
+    }
+};
+
+/// Controller that fails while starting the test case
+struct ThrowingController : public TestController
+{
+    bool test_case_begin(const TestCase& test_case, const TestCaseResult& test_case_result) override
+    {
+        throw std::runtime_error("controller failed");
+    }
+};
+
+class Tests : public TestCase
+{
+    using TestCase::TestCase;
+
+    void register_tests() override
+    {
+        add_method("serialize_results", []() {
+            TestCaseResult r("testcase");
+            r.fail_teardown = "teardown failed";
+            r.elapsed = 1.25;
+
+            TestMethodResult ok("testcase", "ok");
+            ok.elapsed = 0.5;
+            r.add_test_method(std::move(ok));
+
+            TestMethodResult failed("testcase", "failed");
+            failed.error_message = "value is wrong";
+            failed.error_stack.emplace_back("file.cc", 42, "actual(value) == 1");
+            failed.error_stack.back().local_info = "value: 2";
+            failed.error_stack.emplace_back("other.cc", 7, "check()");
+            failed.exception_typeid = "St13runtime_error";
+            failed.elapsed = 0.125;
+            r.add_test_method(std::move(failed));
+
+            TestMethodResult skipped("testcase", "skipped");
+            skipped.skipped = true;
+            r.add_test_method(std::move(skipped));
+
+            ResultWriter writer;
+            writer.add(r);
+
+            TestCaseResult r1("testcase");
+            ResultReader reader(writer.out);
+            reader.test_case(r1);
+            wassert(actual(reader.pos) == writer.out.size());
+
+            wassert(actual(r1.fail_setup) == "");
+            wassert(actual(r1.fail_teardown) == "teardown failed");
+            wassert_false(r1.skipped);
+            wassert(actual(r1.elapsed) == 1.25);
+            wassert(actual(r1.methods.size()) == 3u);
+
+            wassert(actual(r1.methods[0].test_case) == "testcase");
+            wassert(actual(r1.methods[0].test_method) == "ok");
+            wassert_true(r1.methods[0].is_success());
+            wassert(actual(r1.methods[0].elapsed) == 0.5);
+
+            const TestMethodResult& f = r1.methods[1];
+            wassert(actual(f.test_method) == "failed");
+            wassert(actual(f.error_message) == "value is wrong");
+            wassert(actual(f.error_stack.size()) == 2u);
+            wassert(actual(f.error_stack[0].file) == "file.cc");
+            wassert(actual(f.error_stack[0].line) == 42);
+            wassert(actual(f.error_stack[0].call) == "actual(value) == 1");
+            wassert(actual(f.error_stack[0].local_info) == "value: 2");
+            wassert(actual(f.error_stack[1].file) == "other.cc");
+            wassert(actual(f.error_stack[1].line) == 7);
+            wassert(actual(f.exception_typeid) == "St13runtime_error");
+            wassert(actual(f.elapsed) == 0.125);
+
+            wassert_true(r1.methods[2].skipped);
+        });
+
+        add_method("serialize_truncated", []() {
+            TestCaseResult r("testcase");
+            r.add_test_method(TestMethodResult("testcase", "method"));
+            ResultWriter writer;
+            writer.add(r);
+
+            string truncated = writer.out.substr(0, writer.out.size() - 3);
+            TestCaseResult r1("testcase");
+            ResultReader reader(truncated);
+            wassert(actual_function([&] { reader.test_case(r1); }).throws("truncated test results"));
+
+            string empty;
+            ResultReader reader1(empty);
+            wassert(actual_function([&] { reader1.str(); }).throws("truncated test results"));
+        });
+
+        add_method("run_forked", []() {
+            TestRegistry registry;
+            OneMethod ok(registry, "ok", []() {});
+            OneMethod failed(registry, "failed", []() {
+                throw std::runtime_error("expected failure");
+            });
+            OneMethod exited(registry, "exited", []() { _exit(3); });
+            OneMethod killed(registry, "killed", []() { abort(); });
+
+            TestController controller;
+            auto res = registry.run_tests(controller, 2);
+            wassert(actual(res.size()) == 4u);
+
+            // Results are reported in registration order
+            wassert(actual(res[0].test_case) == "ok");
+            wassert(actual(res[0].fail_setup) == "");
+            wassert(actual(res[0].methods.size()) == 1u);
+            wassert_true(res[0].methods[0].is_success());
+
+            wassert(actual(res[1].test_case) == "failed");
+            wassert(actual(res[1].methods.size()) == 1u);
+            wassert(actual(res[1].methods[0].error_message) == "expected failure");
+
+            // Workers that die without reporting results fail in setup
+            wassert(actual(res[2].test_case) == "exited");
+            wassert(actual(res[2].methods.size()) == 0u);
+            wassert(actual(res[2].fail_setup).contains("exited with status 3"));
+
+            wassert(actual(res[3].test_case) == "killed");
+            wassert(actual(res[3].methods.size()) == 0u);
+            wassert(actual(res[3].fail_setup).contains("killed by signal"));
+        });
+
+        add_method("run_forked_exception", []() {
+            // Exceptions in the worker do not escape into the parent loop
+            TestRegistry registry;
+            OneMethod ok(registry, "ok", []() {});
+            ThrowingController controller;
+            auto res = registry.run_tests(controller, 2);
+            wassert(actual(res.size()) == 1u);
+            wassert(actual(res[0].fail_setup).contains("exited with status 1"));
+        });
+    }
+} tests("utils_tests");
+
+}
@@ -12,7 +12,15 @@
 #include <cmath>
 #include <iomanip>
 #include <sys/types.h>
+#include <sys/wait.h>
 #include <regex.h>
+#include <unistd.h>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <map>
+#include <set>
+#include <system_error>
 
 using namespace std;
 using namespace ept;
@@ -442,9 +450,224 @@ std::vector<TestCaseResult> TestRegistry::run_tests(TestController& controller)
     return res;
 }
 
+void ResultWriter::add(const std::string& val)
+{
+    out += to_string(val.size());
+    out += ':';
+    out += val;
+    out += ',';
+}
+
+void ResultWriter::add(double val)
+{
+    char buf[32];
+    snprintf(buf, 32, "%.9g", val);
+    add(std::string(buf));
+}
+
+void ResultWriter::add(const TestMethodResult& r)
+{
+    add(r.test_method);
+    add(r.error_message);
+    add(r.error_stack.size());
+    for (const auto& frame: r.error_stack)
+    {
+        add(frame.file);
+        add(frame.line);
+        add(frame.call);
+        add(frame.local_info);
+    }
+    add(r.exception_typeid);
+    add(r.skipped);
+    add(r.elapsed);
+}
+
+void ResultWriter::add(const TestCaseResult& r)
+{
+    add(r.fail_setup);
+    add(r.fail_teardown);
+    add(r.skipped);
+    add(r.elapsed);
+    add(r.methods.size());
+    for (const auto& m: r.methods)
+        add(m);
+}
+
+namespace {
+
+/**
+ * Return a pointer to a copy of \a s that lasts until the end of the program,
+ * for TestStackFrame fields that are normally string literals
+ */
+const char* intern(const std::string& s)
+{
+    static std::set<std::string> strings;
+    return strings.insert(s).first->c_str();
+}
+
+}
+
+std::string ResultReader::str()
+{
+    size_t sep = in.find(':', pos);
+    if (sep == std::string::npos)
+        throw std::runtime_error("truncated test results");
+    size_t len = strtoul(in.c_str() + pos, 0, 10);
+    if (sep + 1 + len >= in.size() || in[sep + 1 + len] != ',')
+        throw std::runtime_error("truncated test results");
+    std::string res = in.substr(sep + 1, len);
+    pos = sep + 2 + len;
+    return res;
+}
+
+TestMethodResult ResultReader::method(const std::string& test_case)
+{
+    TestMethodResult res(test_case, str());
+    res.error_message = str();
+    size_t frames = num();
+    for (size_t i = 0; i < frames; ++i)
+    {
+        const char* file = intern(str());
+        int line = num();
+        const char* call = intern(str());
+        res.error_stack.emplace_back(file, line, call);
+        res.error_stack.back().local_info = str();
+    }
+    res.exception_typeid = str();
+    res.skipped = flag();
+    res.elapsed = real();
+    return res;
+}
+
+void ResultReader::test_case(TestCaseResult& res)
+{
+    res.fail_setup = str();
+    res.fail_teardown = str();
+    res.skipped = flag();
+    res.elapsed = real();
+    size_t count = num();
+    for (size_t i = 0; i < count; ++i)
+        res.add_test_method(method(res.test_case));
+}
+
+namespace {
+
+std::string read_all(FILE* in)
+{
+    std::string res;
+    rewind(in);
+    char buf[4096];
+    while (size_t count = fread(buf, 1, 4096, in))
+        res.append(buf, count);
+    return res;
+}
+
+/// Test case running in a worker process
+struct Worker
+{
+    size_t index;
+    /// Standard output of the worker
+    FILE* out;
+    /// Serialized results of the worker
+    FILE* results;
+};
+
+}
+
+std::vector<TestCaseResult> TestRegistry::run_tests(TestController& controller, unsigned jobs)
+{
+    if (jobs <= 1)
+        return run_tests(controller);
+
+    std::vector<TestCaseResult> res;
+    for (auto& e: entries)
+    {
+        e->register_tests();
+        res.emplace_back(e->name);
+    }
+
+    std::map<pid_t, Worker> running;
+    size_t next = 0;
+    while (next < entries.size() || !running.empty())
+    {
+        // Start new workers until all jobs are used
+        while (next < entries.size() && running.size() < jobs)
+        {
+            Worker w;
+            w.index = next++;
+            w.out = tmpfile();
+            w.results = tmpfile();
+            if (!w.out || !w.results)
+                throw std::system_error(errno, std::system_category(), "cannot create temporary file for test results");
+
+            // Anything still buffered would be printed again by the child
+            fflush(stdout);
+            fflush(stderr);
+            pid_t pid = fork();
+            if (pid == -1)
+                throw std::system_error(errno, std::system_category(), "cannot fork test worker");
+            if (pid == 0)
+            {
+                // Never unwind into the scheduling loop of the parent, and
+                // skip static destructors and atexit handlers, which belong
+                // to the parent
+                try {
+                    dup2(fileno(w.out), 1);
+                    TestCaseResult r = entries[w.index]->run_tests(controller);
+                    ResultWriter writer;
+                    writer.add(r);
+                    fwrite(writer.out.data(), writer.out.size(), 1, w.results);
+                    fflush(w.results);
+                    fflush(stdout);
+                } catch (...) {
+                    fflush(stdout);
+                    _exit(1);
+                }
+                _exit(0);
+            }
+            running.insert(make_pair(pid, w));
+        }
+
+        // Wait for a worker to finish
+        int status;
+        pid_t pid = waitpid(-1, &status, 0);
+        if (pid == -1)
+        {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::system_category(), "cannot wait for test workers");
+        }
+        auto w = running.find(pid);
+        if (w == running.end())
+            continue;
+
+        string out = read_all(w->second.out);
+        fwrite(out.data(), out.size(), 1, stdout);
+        fflush(stdout);
+
+        TestCaseResult& r = res[w->second.index];
+        string serialized = read_all(w->second.results);
+        try {
+            ResultReader reader(serialized);
+            reader.test_case(r);
+        } catch (std::exception& e) {
+            if (WIFSIGNALED(status))
+                r.fail_setup = "test case process was killed by signal " + to_string(WTERMSIG(status));
+            else
+                r.fail_setup = "test case process exited with status " + to_string(WEXITSTATUS(status)) + " without reporting results";
+        }
+
+        fclose(w->second.out);
+        fclose(w->second.results);
+        running.erase(w);
+    }
+
+    return res;
+}
+
 TestCaseResult TestCase::run_tests(TestController& controller)
 {
     TestCaseResult res(name);
+    auto start = std::chrono::steady_clock::now();
 
     if (!controller.test_case_begin(*this, res))
     {
@@ -473,6 +696,7 @@ TestCaseResult TestCase::run_tests(TestController& controller)
         res.set_teardown_failed(e);
     }
 
+    res.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     controller.test_case_end(*this, res);
     return res;
 }
@@ -498,6 +722,7 @@ TestMethodResult TestCase::run_test(TestController& controller, TestMethod& meth
 
     if (run)
     {
+        auto start = std::chrono::steady_clock::now();
         try {
             method.test_function();
         } catch (TestFailed& e) {
@@ -510,6 +735,7 @@ TestMethodResult TestCase::run_test(TestController& controller, TestMethod& meth
             // An unknown exception was thrown
             res.set_unknown_exception();
         }
+        res.elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
     }
 
     try {
@@ -550,10 +776,8 @@ void SimpleTestController::test_case_end(const TestCase& test_case, const TestCa
 {
     if (test_case_result.skipped)
         ;
-    else if (test_case_result.is_success())
-        fprintf(stdout, "\n");
     else
-        fprintf(stdout, "\n");
+        fprintf(stdout, " %.3fs\n", test_case_result.elapsed);
     fflush(stdout);
 }
 
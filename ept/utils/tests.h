@@ -14,6 +14,7 @@
 #include <exception>
 #include <functional>
 #include <vector>
+#include <cstdlib>
 
 namespace ept {
 namespace tests {
@@ -399,6 +400,8 @@ struct TestMethodResult
     /// True if the test has been skipped
     bool skipped = false;
 
+    /// Time it took to run the test method, in seconds
+    double elapsed = 0;
 
     TestMethodResult(const std::string& test_case, const std::string& test_method)
         : test_case(test_case), test_method(test_method) {}
@@ -460,6 +463,8 @@ struct TestCaseResult
     std::string fail_teardown;
     /// Set to true if this test case has been skipped
     bool skipped = false;
+    /// Time it took to run the whole test case, in seconds
+    double elapsed = 0;
 
     TestCaseResult(const std::string& test_case) : test_case(test_case) {}
 
@@ -500,6 +505,48 @@ struct TestCaseResult
     }
 };
 
+/**
+ * Serialization of test results, to send them from the worker processes of
+ * TestRegistry::run_tests to the parent. Values are encoded as netstrings:
+ * "<length>:<data>,"
+ */
+struct ResultWriter
+{
+    std::string out;
+
+    void add(const std::string& val);
+    void add(const char* val) { add(std::string(val ? val : "")); }
+    void add(bool val) { add(std::string(val ? "1" : "0")); }
+    void add(int val) { add(std::to_string(val)); }
+    void add(size_t val) { add(std::to_string(val)); }
+    void add(double val);
+    void add(const TestMethodResult& r);
+    void add(const TestCaseResult& r);
+};
+
+/**
+ * Read test results serialized by ResultWriter.
+ *
+ * All methods throw std::runtime_error if the input is truncated.
+ */
+struct ResultReader
+{
+    const std::string& in;
+    size_t pos = 0;
+
+    ResultReader(const std::string& in) : in(in) {}
+
+    std::string str();
+    size_t num() { return strtoul(str().c_str(), 0, 10); }
+    bool flag() { return str() == "1"; }
+    double real() { return strtod(str().c_str(), 0); }
+
+    TestMethodResult method(const std::string& test_case);
+
+    /// Read the results of a test case into \a res
+    void test_case(TestCaseResult& res);
+};
+
 struct TestCase;
 struct TestCaseResult;
 struct TestMethod;
@@ -587,6 +634,23 @@ struct TestRegistry
      */
     std::vector<TestCaseResult> run_tests(TestController& controller);
 
+    /**
+     * Run all the registered tests using the given controller, running up to
+     * \a jobs test cases at the same time.
+     *
+     * If \a jobs is greater than 1, each test case is run in a forked child
+     * process, so that changes to the global state made by a test case (like
+     * apt configuration or environment variables) do not affect the others.
+     * The standard output of each child is printed when it ends, so that the
+     * progress output of the test cases does not get mixed.
+     *
+     * A test case whose process dies without reporting its results is
+     * reported as failed in setup.
+     *
+     * Results are returned in registration order.
+     */
+    std::vector<TestCaseResult> run_tests(TestController& controller, unsigned jobs);
+
     /// Get the singleton instance of TestRegistry
     static TestRegistry& get();
 };
@@ -624,6 +688,14 @@ struct TestCase
     {
         TestRegistry::get().register_test_case(*this);
     }
+
+    /// Register with \a registry instead of the singleton instance
+    TestCase(TestRegistry& registry, const std::string& name)
+        : name(name)
+    {
+        registry.register_test_case(*this);
+    }
+
     virtual ~TestCase() {}
 
     /**
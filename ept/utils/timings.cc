@@ -0,0 +1,78 @@
+/*
+ * Timing of the phases of long operations
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA 02111-1307  USA
+ */
+
+#include "timings.h"
+#include <cstdlib>
+
+using namespace std;
+
+namespace ept {
+namespace timings {
+
+void PhaseTimings::add(const std::string& name, double seconds)
+{
+    phases.push_back(Phase{name, seconds});
+}
+
+double PhaseTimings::get(const std::string& name) const
+{
+    double res = 0;
+    for (const auto& p : phases)
+        if (p.name == name)
+            res += p.seconds;
+    return res;
+}
+
+double PhaseTimings::total() const
+{
+    double res = 0;
+    for (const auto& p : phases)
+        res += p.seconds;
+    return res;
+}
+
+void PhaseTimings::print(FILE* out, const std::string& label) const
+{
+    fprintf(out, "%s:", label.c_str());
+    for (const auto& p : phases)
+        fprintf(out, " %s=%.3fms", p.name.c_str(), p.seconds * 1000.0);
+    fprintf(out, " total=%.3fms\n", total() * 1000.0);
+}
+
+void PhaseTimings::report(const std::string& label) const
+{
+    if (!getenv("EPT_PROFILE_STARTUP"))
+        return;
+    print(stderr, label);
+}
+
+Timer::Timer(PhaseTimings& timings, const std::string& name)
+    : timings(timings), name(name), start(chrono::steady_clock::now()), running(true)
+{
+}
+
+void Timer::stop()
+{
+    if (!running) return;
+    running = false;
+    chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    timings.add(name, elapsed.count());
+}
+
+}
+}
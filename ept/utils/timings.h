@@ -0,0 +1,74 @@
+#ifndef EPT_TIMINGS_H
+#define EPT_TIMINGS_H
+
+/**
+ * @brief Timing of the phases of long operations
+ */
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdio>
+
+namespace ept {
+namespace timings {
+
+/**
+ * Wall clock time spent in each phase of an operation, like loading a data
+ * source.
+ */
+struct PhaseTimings
+{
+    struct Phase
+    {
+        std::string name;
+        double seconds;
+    };
+
+    /// Phases in the order they were run
+    std::vector<Phase> phases;
+
+    /// Add the duration of a phase
+    void add(const std::string& name, double seconds);
+
+    /// Return the time spent in a phase, or 0 if it was not run
+    double get(const std::string& name) const;
+
+    /// Return the time spent in all phases
+    double total() const;
+
+    /// Print the timings on one line, prefixed by label
+    void print(FILE* out, const std::string& label) const;
+
+    /**
+     * Print the timings to stderr if $EPT_PROFILE_STARTUP is set in the
+     * environment.
+     */
+    void report(const std::string& label) const;
+};
+
+/**
+ * Measure the time from construction until stop() or destruction, and add it
+ * to a PhaseTimings.
+ */
+class Timer
+{
+    PhaseTimings& timings;
+    std::string name;
+    std::chrono::steady_clock::time_point start;
+    bool running;
+
+public:
+    Timer(PhaseTimings& timings, const std::string& name);
+    Timer(const Timer&) = delete;
+    ~Timer() { stop(); }
+    Timer& operator=(const Timer&) = delete;
+
+    /// Record the time elapsed so far, if it has not been recorded yet
+    void stop();
+};
+
+}
+}
+
+#endif
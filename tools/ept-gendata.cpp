@@ -0,0 +1,397 @@
+/*
+ * Generate large synthetic datasets for benchmarking
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * ept-gendata scales up a dataset in the layout of ept/test-data (packagelist,
+ * dpkg-status, debtags/package-tags and debtags/vocabulary).
+ *
+ * Every package is replicated --scale times, with a "-genN" suffix added to
+ * its name and to the names of the packages of the dataset it refers to in
+ * relationship fields, and with sizes randomly changed by up to 20%.  This
+ * keeps the distribution of field sizes, tags per package and relationships
+ * of the original data.
+ *
+ * With --tag-scale, facets are replicated in the same way, and each tag of
+ * a generated package is moved to a random copy of its facet, so that the
+ * vocabulary grows and the cardinality of each tag shrinks.
+ *
+ * Generated package records also get a Tag: field with their tags, using
+ * brace expansion for tags in the same facet.
+ *
+ * The result can be used for the test suite and the benchmarks, by pointing
+ * run-check to it with $EPT_TEST_DATA.
+ */
+
+#include <ept/apt/relation.h>
+#include <ept/debtags/coll/fast.h>
+#include <ept/debtags/coll/TextFormat.h>
+#include <ept/utils/sys.h>
+#include <ept/utils/string.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <vector>
+
+using namespace std;
+using namespace ept;
+
+namespace {
+
+struct Options
+{
+    unsigned scale = 10;
+    unsigned tag_scale = 1;
+    unsigned seed = 1;
+    string srcdir;
+    string dstdir;
+};
+
+// A record as a list of (field name, raw field value) pairs
+typedef vector<pair<string, string>> Record;
+
+const char* relation_fields[] = {
+    "Depends", "Pre-Depends", "Recommends", "Suggests", "Enhances",
+    "Conflicts", "Breaks", "Replaces", "Provides", 0
+};
+
+vector<Record> read_records(const string& pathname)
+{
+    string data = sys::read_file(pathname);
+    vector<Record> res;
+    Record rec;
+    size_t pos = 0;
+    while (pos < data.size())
+    {
+        size_t end = data.find('\n', pos);
+        if (end == string::npos) end = data.size();
+        string line = data.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (line.empty())
+        {
+            if (!rec.empty())
+                res.push_back(move(rec));
+            rec.clear();
+        } else if (isspace(line[0])) {
+            // Continuation line
+            if (rec.empty())
+                throw runtime_error(pathname + ": continuation line at the beginning of a record");
+            rec.back().second += "\n" + line;
+        } else {
+            size_t colon = line.find(':');
+            if (colon == string::npos)
+                throw runtime_error(pathname + ": line without a field name: " + line);
+            size_t start = colon + 1;
+            while (start < line.size() && line[start] == ' ')
+                ++start;
+            rec.push_back(make_pair(line.substr(0, colon), line.substr(start)));
+        }
+    }
+    if (!rec.empty())
+        res.push_back(move(rec));
+    return res;
+}
+
+string format_record(const Record& rec)
+{
+    string res;
+    for (const auto& f : rec)
+    {
+        res += f.first;
+        res += ": ";
+        res += f.second;
+        res += "\n";
+    }
+    res += "\n";
+    return res;
+}
+
+string field(const Record& rec, const string& name)
+{
+    for (const auto& f : rec)
+        if (f.first == name)
+            return f.second;
+    return string();
+}
+
+string suffixed(const string& name, unsigned copy)
+{
+    if (copy == 0) return name;
+    return name + "-gen" + to_string(copy);
+}
+
+class Generator
+{
+    const Options& opts;
+    mt19937 rng;
+
+    // Package names of the source dataset
+    set<string> names;
+
+    // Tags of each generated package
+    map<string, set<string>> generated_tags;
+
+public:
+    Generator(const Options& opts) : opts(opts), rng(opts.seed) {}
+
+    // Add the suffix of copy to the package names in a relationship field
+    // that are part of the dataset
+    string rename_relations(const string& value, unsigned copy)
+    {
+        if (copy == 0) return value;
+        apt::RelationList rels;
+        if (!rels.tryParse(value))
+            return value;
+        string res;
+        size_t pos = 0;
+        for (size_t i = 0; i < rels.size(); ++i)
+        {
+            const apt::RelationList::Span& name = rels[i].name;
+            string n = rels.str(name);
+            if (names.find(n) == names.end())
+                continue;
+            res += value.substr(pos, name.offset + name.size - pos);
+            res += "-gen" + to_string(copy);
+            pos = name.offset + name.size;
+        }
+        res += value.substr(pos);
+        return res;
+    }
+
+    // Scale a size by a random factor between 0.8 and 1.2
+    string perturb_size(const string& value)
+    {
+        unsigned long long size = strtoull(value.c_str(), 0, 10);
+        uniform_real_distribution<double> factor(0.8, 1.2);
+        return to_string((unsigned long long)(size * factor(rng)));
+    }
+
+    // Pick a random copy of the facet of a tag
+    string scale_tag(const string& tag)
+    {
+        if (opts.tag_scale <= 1) return tag;
+        size_t sep = tag.find("::");
+        if (sep == string::npos) return tag;
+        uniform_int_distribution<unsigned> pick(0, opts.tag_scale - 1);
+        return suffixed(tag.substr(0, sep), pick(rng)) + tag.substr(sep);
+    }
+
+    // Format tags for a Tag: field, grouping tags of the same facet in braces
+    static string format_tags(const set<string>& tags)
+    {
+        map<string, vector<string>> by_facet;
+        for (const auto& t : tags)
+        {
+            size_t sep = t.find("::");
+            if (sep == string::npos)
+                by_facet[t];
+            else
+                by_facet[t.substr(0, sep)].push_back(t.substr(sep + 2));
+        }
+        string res;
+        for (const auto& f : by_facet)
+        {
+            if (!res.empty()) res += ", ";
+            res += f.first;
+            if (f.second.empty()) continue;
+            res += "::";
+            if (f.second.size() == 1)
+                res += f.second[0];
+            else
+                res += "{" + str::join(",", f.second.begin(), f.second.end()) + "}";
+        }
+        return res;
+    }
+
+    void generate_tags(const string& src, const string& dst)
+    {
+        FILE* in = fopen(src.c_str(), "rt");
+        if (!in)
+            throw std::system_error(errno, std::system_category(), "cannot open " + src);
+        debtags::coll::Fast coll;
+        try {
+            debtags::coll::textformat::parse(in, src, coll);
+        } catch (...) {
+            fclose(in);
+            throw;
+        }
+        fclose(in);
+
+        string out;
+        for (const auto& i : coll)
+            for (unsigned copy = 0; copy < opts.scale; ++copy)
+            {
+                set<string> tags;
+                for (const auto& t : i.second)
+                    tags.insert(scale_tag(t));
+                string name = suffixed(i.first, copy);
+                out += name + ": " + str::join(", ", tags.begin(), tags.end()) + "\n";
+                generated_tags[name] = move(tags);
+            }
+        sys::write_file(dst, out, 0666);
+    }
+
+    void generate_vocabulary(const string& src, const string& dst)
+    {
+        string out;
+        vector<Record> records = read_records(src);
+        for (unsigned copy = 0; copy < opts.tag_scale; ++copy)
+            for (Record rec : records)
+            {
+                for (auto& f : rec)
+                {
+                    if (f.first == "Facet")
+                        f.second = suffixed(f.second, copy);
+                    else if (f.first == "Tag")
+                    {
+                        size_t sep = f.second.find("::");
+                        if (sep != string::npos)
+                            f.second = suffixed(f.second.substr(0, sep), copy) + f.second.substr(sep);
+                    }
+                }
+                out += format_record(rec);
+            }
+        sys::write_file(dst, out, 0666);
+    }
+
+    void generate_packages(const string& src, const string& dst, bool add_tags)
+    {
+        vector<Record> records = read_records(src);
+        names.clear();
+        for (const auto& r : records)
+            names.insert(field(r, "Package"));
+
+        string out;
+        for (unsigned copy = 0; copy < opts.scale; ++copy)
+            for (Record rec : records)
+            {
+                string orig = field(rec, "Package");
+                string name = suffixed(orig, copy);
+                bool has_tags = false;
+                for (auto& f : rec)
+                {
+                    if (f.first == "Package")
+                        f.second = name;
+                    else if (f.first == "Installed-Size" || f.first == "Size")
+                        f.second = perturb_size(f.second);
+                    else if (f.first == "Filename" && copy)
+                    {
+                        size_t pos = f.second.rfind("/" + orig + "_");
+                        if (pos != string::npos)
+                            f.second.replace(pos + 1, orig.size(), name);
+                    } else if (f.first == "Tag")
+                        has_tags = true;
+                    else
+                        for (const char** r = relation_fields; *r; ++r)
+                            if (f.first == *r)
+                                f.second = rename_relations(f.second, copy);
+                }
+
+                if (add_tags && !has_tags)
+                {
+                    auto t = generated_tags.find(name);
+                    if (t != generated_tags.end() && !t->second.empty())
+                    {
+                        // Keep Tag: before Description:, like the archive does
+                        auto pos = rec.begin();
+                        while (pos != rec.end() && pos->first != "Description")
+                            ++pos;
+                        rec.insert(pos, make_pair(string("Tag"), format_tags(t->second)));
+                    }
+                }
+
+                out += format_record(rec);
+            }
+        sys::write_file(dst, out, 0666);
+    }
+
+    void run()
+    {
+        sys::makedirs(str::joinpath(opts.dstdir, "debtags"));
+
+        // Tags first, so that package records can include them
+        generate_tags(str::joinpath(opts.srcdir, "debtags/package-tags"),
+                      str::joinpath(opts.dstdir, "debtags/package-tags"));
+        generate_vocabulary(str::joinpath(opts.srcdir, "debtags/vocabulary"),
+                            str::joinpath(opts.dstdir, "debtags/vocabulary"));
+        generate_packages(str::joinpath(opts.srcdir, "packagelist"),
+                          str::joinpath(opts.dstdir, "packagelist"), true);
+        generate_packages(str::joinpath(opts.srcdir, "dpkg-status"),
+                          str::joinpath(opts.dstdir, "dpkg-status"), false);
+    }
+};
+
+void usage(FILE* out)
+{
+    fprintf(out, "Usage: ept-gendata [--scale N] [--tag-scale N] [--seed N] srcdir dstdir\n"
+                 "\n"
+                 "Generate a dataset N times the size of the one in srcdir, which has the\n"
+                 "same layout as ept/test-data.\n"
+                 "\n"
+                 "  --scale N      number of copies of each package (default: 10)\n"
+                 "  --tag-scale N  number of copies of each facet (default: 1)\n"
+                 "  --seed N       seed for the random number generator (default: 1)\n");
+}
+
+}
+
+int main(int argc, const char* argv[])
+{
+    Options opts;
+    vector<string> args;
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg(argv[i]);
+        if (arg == "--help" || arg == "-h")
+        {
+            usage(stdout);
+            return 0;
+        } else if ((arg == "--scale" || arg == "--tag-scale" || arg == "--seed") && i + 1 < argc) {
+            unsigned val = strtoul(argv[++i], 0, 10);
+            if (arg == "--scale")
+                opts.scale = val;
+            else if (arg == "--tag-scale")
+                opts.tag_scale = val;
+            else
+                opts.seed = val;
+        } else
+            args.push_back(arg);
+    }
+    if (args.size() != 2 || opts.scale == 0 || opts.tag_scale == 0)
+    {
+        usage(stderr);
+        return 1;
+    }
+    opts.srcdir = args[0];
+    opts.dstdir = args[1];
+
+    try {
+        Generator gen(opts);
+        gen.run();
+    } catch (std::exception& e) {
+        fprintf(stderr, "ept-gendata: %s\n", e.what());
+        return 1;
+    }
+    return 0;
+}